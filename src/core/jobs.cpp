@@ -0,0 +1,236 @@
+#include "jobs.hpp"
+#include <condition_variable>
+#include <cstdlib>
+#include <thread>
+
+// Owner pushes and pops at 'bottom', thieves take from 'top'
+struct Job_queue {
+    std::mutex lock;
+    Job jobs[JOB_QUEUE_SIZE];
+    Uint32 top = 0;
+    Uint32 bottom = 0;
+};
+
+static Job_queue* queues = nullptr;     // One per thread, 0 belongs to the thread that initialized the pool
+static int queue_count = 0;
+static std::vector<std::thread> workers;
+static std::once_flag init_once;
+static std::atomic<bool> running = false;
+static std::atomic<bool> quit = false;
+
+static std::atomic<int> queued = 0;     // Jobs sitting in any queue
+static std::atomic<int> sleepers = 0;
+static std::atomic<Uint32> next_queue = 0;
+static std::mutex sleep_mutex;
+static std::condition_variable sleep_cv;
+
+static thread_local int worker_index = -1;  // -1 for threads outside the pool
+
+
+static bool push_job(Job_queue& queue, const Job& job) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.bottom - queue.top >= JOB_QUEUE_SIZE) return false;
+    queue.jobs[queue.bottom++ % JOB_QUEUE_SIZE] = job;
+    return true;
+}
+
+
+static bool pop_job(Job_queue& queue, Job& out) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.bottom == queue.top) return false;
+    out = queue.jobs[--queue.bottom % JOB_QUEUE_SIZE];
+    return true;
+}
+
+
+static bool steal_job(Job_queue& queue, Job& out) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.bottom == queue.top) return false;
+    out = queue.jobs[queue.top++ % JOB_QUEUE_SIZE];
+    return true;
+}
+
+
+// Own jobs first (newest, still warm in cache), then the oldest job of the next busy thread
+static bool find_job(Job& out) {
+    if (queued.load() == 0) return false;
+    int self = worker_index;
+    if (self >= 0 && pop_job(queues[self], out)) {
+        queued--;
+        return true;
+    }
+
+    int start = (self >= 0) ? self + 1 : 0;
+    for (int i = 0; i < queue_count; i++) {
+        int victim = (start + i) % queue_count;
+        if (victim != self && steal_job(queues[victim], out)) {
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// The last decrement happens under the lock, so a waiter can't destroy the counter while it's still in use here
+static void finish_job(Job_counter* counter) {
+    if (counter == nullptr) return;
+
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> guard(counter->lock);
+        if (--counter->count > 0) return;
+        ready.swap(counter->continuations);
+    }
+    for (const Job& job : ready) {
+        job_submit(job);
+        finish_job(job.counter);    // Counted once already by job_submit_after
+    }
+}
+
+
+static void execute(Job& job) {
+    job.run(job.payload);
+    finish_job(job.counter);
+}
+
+
+static void worker_loop(int index) {
+    worker_index = index;
+    while (!quit) {
+        Job job;
+        if (find_job(job)) {
+            execute(job);
+            continue;
+        }
+
+        // 'sleepers' goes up before 'queued' is checked, submitters check them the other way around
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleepers++;
+        sleep_cv.wait(lock, []() { return quit || queued.load() > 0; });
+        sleepers--;
+    }
+}
+
+
+void jobs_init(int worker_count) {
+    std::call_once(init_once, [worker_count]() {
+        int count = (worker_count > 0) ? worker_count : SDL_GetNumLogicalCPUCores() - 1;
+        count = SDL_clamp(count, 0, MAX_JOB_WORKERS);
+
+        queue_count = count + 1;
+        queues = new Job_queue[queue_count];
+        worker_index = 0;
+        running = true;
+        for (int i = 1; i <= count; i++) {
+            workers.emplace_back(worker_loop, i);
+        }
+        SDL_Log("> Job system started. {%d workers}", count);
+
+        // Callers that never shut the pool down still join the workers, before the statics above are destroyed
+        std::atexit(jobs_shutdown);
+    });
+}
+
+
+void jobs_shutdown() {
+    if (!running) return;
+
+    // Drain what is left, then wake everyone up to leave
+    Job job;
+    while (find_job(job)) execute(job);
+    running = false;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        quit = true;
+    }
+    sleep_cv.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+}
+
+
+int jobs_thread_count() {
+    return running ? queue_count : 1;
+}
+
+
+void job_submit(const Job& job) {
+    jobs_init();
+    if (job.counter) job.counter->count++;
+
+    Job_queue* queue = nullptr;
+    if (running) {
+        int index = (worker_index >= 0) ? worker_index : (int)(next_queue++ % queue_count);
+        queue = &queues[index];
+    }
+
+    if (queue == nullptr || !push_job(*queue, job)) {
+        Job inline_job = job;       // Queue full or pool stopped, run it here
+        execute(inline_job);
+        return;
+    }
+
+    queued++;
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        sleep_cv.notify_one();
+    }
+}
+
+
+void job_submit_after(Job_counter& dependency, const Job& job) {
+    if (job.counter) job.counter->count++;
+    {
+        std::lock_guard<std::mutex> guard(dependency.lock);
+        if (dependency.count.load() > 0) {
+            dependency.continuations.push_back(job);
+            return;
+        }
+    }
+    job_submit(job);
+    finish_job(job.counter);
+}
+
+
+void job_wait(Job_counter& counter) {
+    while (counter.count.load() > 0) {
+        Job job;
+        if (find_job(job)) execute(job);
+        else std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> guard(counter.lock);    // The last finisher is out
+}
+
+
+void job_parallel_for(int count, int grain, const std::function<void(int begin, int end)>& fn) {
+    grain = SDL_max(grain, 1);
+    if (count <= grain) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    Job_counter counter;
+    const std::function<void(int, int)>* body = &fn;
+    for (int begin = 0; begin < count; begin += grain) {
+        int end = SDL_min(begin + grain, count);
+        job_run([body, begin, end]() { (*body)(begin, end); }, &counter);
+    }
+    job_wait(counter);
+}
+
+
+double job_benchmark(int job_count) {
+    jobs_init();
+    Job_counter counter;
+    Uint64 start = SDL_GetTicksNS();
+    for (int done = 0; done < job_count;) {
+        int batch = SDL_min(job_count - done, JOB_QUEUE_SIZE / 2);
+        for (int i = 0; i < batch; i++) {
+            job_run([]() {}, &counter);
+        }
+        job_wait(counter);
+        done += batch;
+    }
+    return (SDL_GetTicksNS() - start) / (double)SDL_max(job_count, 1);
+}
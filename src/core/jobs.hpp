@@ -0,0 +1,146 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define MAX_JOB_WORKERS 64
+#define JOB_QUEUE_SIZE 4096         // Per thread, a full queue runs new jobs inline
+#define JOB_PAYLOAD_SIZE 40         // Bytes of captures a job can carry
+
+struct Job_counter;
+
+/**
+ * @brief A function and its captures, stored inline so scheduling never allocates.
+ */
+struct Job {
+    void (*run)(void* payload) = nullptr;   /**< Calls the callable stored in 'payload'. */
+    Job_counter* counter = nullptr;         /**< Decremented once the job is done, can be nullptr. */
+    alignas(std::max_align_t) unsigned char payload[JOB_PAYLOAD_SIZE];  /**< The callable (trivially copyable). */
+};
+
+/**
+ * @brief Counts unfinished jobs, to wait on them or to start other jobs after them.
+ *        A counter can be reused once it reached zero.
+ */
+struct Job_counter {
+    std::atomic<int> count = 0;         /**< Jobs scheduled with this counter and not done yet. */
+    std::mutex lock;                    /**< Guards 'continuations'. */
+    std::vector<Job> continuations;     /**< Jobs scheduled once 'count' reaches zero. */
+};
+
+
+/**
+ * @brief Starts the worker pool. Called on its own by the first job, calling it first picks the size.
+ *
+ * Every worker, and the thread calling jobs_init, owns a deque: its own jobs are
+ * popped newest first, idle workers steal the oldest jobs of the others.
+ *
+ * @param workers Worker threads besides the caller, 0 for one per logical core minus one.
+ */
+void jobs_init(int workers = 0);
+
+
+/**
+ * @brief Waits for the queued jobs and stops the workers, later jobs run inline on the caller.
+ *        Registered with atexit by jobs_init as well, calling it earlier is still preferred.
+ */
+void jobs_shutdown();
+
+
+/**
+ * @brief Returns the number of threads running jobs, the initializing thread included.
+ * @return The thread count.
+ */
+int jobs_thread_count();
+
+
+/**
+ * @brief Queues a job on the calling thread's deque (any thread can schedule).
+ * @param job The job, its counter is incremented here.
+ */
+void job_submit(const Job& job);
+
+
+/**
+ * @brief Queues a job once every job of a counter is done.
+ * @param dependency The counter to wait for, it runs right away when already zero.
+ * @param job The job, its counter is incremented here so waiting on it covers the delay.
+ */
+void job_submit_after(Job_counter& dependency, const Job& job);
+
+
+/**
+ * @brief Waits until a counter reaches zero, running queued jobs meanwhile instead of blocking.
+ * @param counter The counter to wait on.
+ */
+void job_wait(Job_counter& counter);
+
+
+/**
+ * @brief Runs fn over [0, count) in chunks of 'grain' items spread on the workers, the caller helps.
+ * @param count Number of items.
+ * @param grain Items per job, larger grains amortize scheduling on cheap items.
+ * @param fn Called with [begin, end) of each chunk, from any thread.
+ */
+void job_parallel_for(int count, int grain, const std::function<void(int begin, int end)>& fn);
+
+
+/**
+ * @brief Measures the scheduling overhead: empty jobs are submitted in queue-sized batches and waited on.
+ * @param job_count Number of jobs to run.
+ * @return Nanoseconds per job, from submit to the end of the wait.
+ */
+double job_benchmark(int job_count);
+
+
+/**
+ * @brief Wraps a callable into a Job.
+ * @param fn A small, trivially copyable callable (lambdas capturing pointers, references or numbers).
+ * @param counter Counter to decrement once it ran, can be nullptr.
+ * @return The job.
+ */
+template <typename F>
+Job job_make(F&& fn, Job_counter* counter = nullptr) {
+    using Fn = std::decay_t<F>;
+    static_assert(sizeof(Fn) <= JOB_PAYLOAD_SIZE, "Job captures too large, capture a pointer instead");
+    static_assert(std::is_trivially_copyable_v<Fn>, "Job captures must be trivially copyable");
+
+    Job job;
+    job.counter = counter;
+    new (job.payload) Fn(std::forward<F>(fn));
+    job.run = [](void* payload) { (*(Fn*)payload)(); };
+    return job;
+}
+
+
+/**
+ * @brief Schedules a callable (see job_make).
+ * @param fn The callable.
+ * @param counter Counter tracking it, can be nullptr.
+ */
+template <typename F>
+void job_run(F&& fn, Job_counter* counter = nullptr) {
+    job_submit(job_make(std::forward<F>(fn), counter));
+}
+
+
+/**
+ * @brief Schedules a callable after every job of 'dependency' is done (see job_make).
+ * @param dependency The counter to wait for.
+ * @param fn The callable.
+ * @param counter Counter tracking it, can be nullptr.
+ */
+template <typename F>
+void job_run_after(Job_counter& dependency, F&& fn, Job_counter* counter = nullptr) {
+    job_submit_after(dependency, job_make(std::forward<F>(fn), counter));
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "pacer.hpp"
+#include <cmath>
+
+#define NS_PER_SECOND 1000000000ULL
+#define SLEEP_SLICE_NS 1000000ULL       // Sleep 1 ms at a time, so oversleeping is measured often
+#define MIN_SPIN_NS 200000ULL           // Always spin at least the last 0.2 ms
+
+static SDL_Renderer* rend = nullptr;
+static Pacing_settings settings;
+static Pacing_stats stats;
+static Pacing_mode applied_mode = PACING_UNCAPPED;
+
+static Uint64 deadline = 0;
+static Uint64 last_frame = 0;
+static double oversleep = SLEEP_SLICE_NS;   // Longest recent SDL_DelayNS overshoot, decays slowly
+
+// Accumulated over the current one second window
+static Uint64 window_start = 0;
+static int window_frames = 0;
+static double period_sum = 0;
+static double period_sq_sum = 0;
+static double error_sum = 0;
+static double error_max = 0;
+static int capped_frames = 0;
+static int missed = 0;
+
+
+static void apply_mode() {
+    if (rend != nullptr) SDL_SetRenderVSync(rend, settings.mode == PACING_VSYNC ? 1 : SDL_RENDERER_VSYNC_DISABLED);
+    applied_mode = settings.mode;
+    deadline = 0;
+}
+
+
+void pacer_init(SDL_Renderer* renderer) {
+    rend = renderer;
+    apply_mode();
+    last_frame = SDL_GetTicksNS();
+    window_start = last_frame;
+}
+
+
+Pacing_settings& pacer_settings() {
+    return settings;
+}
+
+
+const Pacing_stats& pacer_stats() {
+    return stats;
+}
+
+
+const char* pacer_mode_name(Pacing_mode mode) {
+    switch (mode) {
+        case PACING_UNCAPPED: return "Uncapped";
+        case PACING_CAPPED:   return "Capped";
+        case PACING_VSYNC:    return "VSync";
+    }
+    return "Unknown";
+}
+
+
+// Coarse sleep in slices while the OS can't overshoot the deadline, then spin the rest
+static void wait_until(Uint64 target) {
+    for (Uint64 now = SDL_GetTicksNS(); now < target && target - now > oversleep + MIN_SPIN_NS; now = SDL_GetTicksNS()) {
+        SDL_DelayNS(SLEEP_SLICE_NS);
+        double overshoot = (double)(SDL_GetTicksNS() - now) - SLEEP_SLICE_NS;
+        oversleep = SDL_max(overshoot, oversleep * 0.99);
+    }
+    while (SDL_GetTicksNS() < target) {}
+}
+
+
+static void pace_capped(Uint64 frame_ns) {
+    Uint64 now = SDL_GetTicksNS();
+    deadline = deadline ? deadline + frame_ns : now;
+
+    capped_frames++;
+    if (now > deadline) {
+        missed++;
+        if (now > deadline + frame_ns) deadline = now;  // Far behind, restart the cadence instead of rushing frames
+    } else {
+        wait_until(deadline);
+    }
+
+    double error = std::fabs((double)SDL_GetTicksNS() - (double)deadline);
+    error_sum += error;
+    error_max = SDL_max(error_max, error);
+}
+
+
+static void flush_window(Uint64 now) {
+    double span = (double)(now - window_start);
+    double mean = window_frames ? period_sum / window_frames : 0;
+    double variance = window_frames ? period_sq_sum / window_frames - mean * mean : 0;
+
+    stats.fps = (float)(window_frames * (double)NS_PER_SECOND / span);
+    stats.frame_ms = (float)(mean / 1e6);
+    stats.jitter_ms = (float)(std::sqrt(SDL_max(variance, 0.0)) / 1e6);
+    stats.error_ms = capped_frames ? (float)(error_sum / capped_frames / 1e6) : 0;
+    stats.error_max_ms = (float)(error_max / 1e6);
+    stats.missed = missed;
+
+    window_start = now;
+    window_frames = 0;
+    period_sum = period_sq_sum = 0;
+    error_sum = error_max = 0;
+    capped_frames = missed = 0;
+}
+
+
+void pacer_frame_end() {
+    if (settings.mode != applied_mode) apply_mode();
+    if (settings.mode == PACING_CAPPED) {
+        pace_capped(NS_PER_SECOND / SDL_max(settings.target_fps, 1));
+    }
+
+    Uint64 now = SDL_GetTicksNS();
+    double period = (double)(now - last_frame);
+    last_frame = now;
+    window_frames++;
+    period_sum += period;
+    period_sq_sum += period * period;
+
+    if (now - window_start >= NS_PER_SECOND) flush_window(now);
+}
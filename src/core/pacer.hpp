@@ -0,0 +1,75 @@
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include <SDL3/SDL.h>
+
+/**
+ * @brief How the end of a frame is paced.
+ */
+enum Pacing_mode {
+    PACING_UNCAPPED,    /**< No waiting at all, frames are presented as fast as they are made. */
+    PACING_CAPPED,      /**< Sleeps, then spins, until the next target_fps deadline (vsync off). */
+    PACING_VSYNC        /**< The renderer waits for the display, nothing is done on the CPU side. */
+};
+
+/**
+ * @brief Options of the frame pacer, read at the end of every frame.
+ */
+struct Pacing_settings {
+    Pacing_mode mode = PACING_VSYNC;    /**< The pacing mode, switching it toggles the renderer's vsync. */
+    int target_fps = 60;                /**< Frame rate of PACING_CAPPED. */
+};
+
+/**
+ * @brief Pacing results over the last second, for the debug UI.
+ */
+struct Pacing_stats {
+    float fps;              /**< Frames presented per second. */
+    float frame_ms;         /**< Average time between two frames. */
+    float jitter_ms;        /**< Standard deviation of the time between two frames. */
+    float error_ms;         /**< Average distance to the deadline when a capped frame ends (waking up late or early). */
+    float error_max_ms;     /**< Largest distance to the deadline. */
+    int missed;             /**< Capped frames whose work alone went past the deadline. */
+};
+
+
+/**
+ * @brief Starts pacing the frames presented by a renderer, and applies the pacing mode's vsync.
+ * @param rend Pointer to the SDL_Renderer presenting the frames.
+ */
+void pacer_init(SDL_Renderer* rend);
+
+
+/**
+ * @brief Returns a reference to the pacing settings.
+ * @return Reference to the settings.
+ */
+Pacing_settings& pacer_settings();
+
+
+/**
+ * @brief Ends a frame, call right after SDL_RenderPresent.
+ *
+ * In PACING_CAPPED it waits until the next deadline: SDL_DelayNS while the
+ * remaining time is larger than the longest recent oversleep, then a short spin
+ * on SDL_GetTicksNS for the rest. Deadlines advance by whole frame times, so a
+ * late frame doesn't push the following ones back.
+ */
+void pacer_frame_end();
+
+
+/**
+ * @brief Returns the pacing stats, updated once per second.
+ * @return The stats.
+ */
+const Pacing_stats& pacer_stats();
+
+
+/**
+ * @brief Readable name of a pacing mode.
+ * @param mode The pacing mode.
+ * @return "Uncapped", "Capped" or "VSync".
+ */
+const char* pacer_mode_name(Pacing_mode mode);
+
+#endif
@@ -0,0 +1,51 @@
+#include "timestep.hpp"
+
+#define NS_PER_SECOND 1000000000ULL
+
+static Timestep_settings settings;
+static Uint64 previous_ns = 0;
+static Uint64 accumulator = 0;     // Elapsed nanoseconds * tick_rate, a tick every NS_PER_SECOND
+static Uint64 dropped = 0;
+
+Timestep_settings& timestep_settings() {
+    return settings;
+}
+
+
+int timestep_advance() {
+    Uint64 now = SDL_GetTicksNS();
+    if (previous_ns == 0) {
+        previous_ns = now;
+        return 0;
+    }
+
+    Uint64 rate = SDL_max(settings.tick_rate, 1u);
+    int max_updates = SDL_max(settings.max_updates, 1);
+    accumulator += (now - previous_ns) * rate;
+    previous_ns = now;
+
+    Uint64 ticks = accumulator / NS_PER_SECOND;
+    accumulator %= NS_PER_SECOND;
+
+    // After a stall, catching up would only make the next frame slower too
+    if (ticks > (Uint64)max_updates) {
+        dropped += ticks - max_updates;
+        ticks = max_updates;
+    }
+    return (int)ticks;
+}
+
+
+float timestep_dt() {
+    return 1.0f / SDL_max(settings.tick_rate, 1u);
+}
+
+
+float timestep_alpha() {
+    return (float)((double)accumulator / NS_PER_SECOND);
+}
+
+
+Uint64 timestep_dropped() {
+    return dropped;
+}
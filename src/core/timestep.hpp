@@ -0,0 +1,53 @@
+#ifndef TIMESTEP_HPP
+#define TIMESTEP_HPP
+
+#include <SDL3/SDL.h>
+
+/**
+ * @brief Options of the fixed simulation timestep.
+ */
+struct Timestep_settings {
+    Uint32 tick_rate = 60;      /**< Simulation updates per second. */
+    int max_updates = 5;        /**< Updates run in a single frame at most, time beyond that is dropped after a stall. */
+};
+
+
+/**
+ * @brief Returns a reference to the timestep settings.
+ * @return Reference to the settings.
+ */
+Timestep_settings& timestep_settings();
+
+
+/**
+ * @brief Measures the time since the last call (SDL_GetTicksNS) and returns how many ticks to simulate.
+ *
+ * Time is accumulated exactly (nanoseconds * tick rate), so the simulation runs at
+ * the tick rate on average without drifting. Call once per frame, the first call returns 0.
+ *
+ * @return The number of updates to run this frame, at most Timestep_settings::max_updates.
+ */
+int timestep_advance();
+
+
+/**
+ * @brief Duration of one tick.
+ * @return Seconds per tick.
+ */
+float timestep_dt();
+
+
+/**
+ * @brief How far the current time is between the last two ticks, for render interpolation.
+ * @return 0 at the last tick, approaching 1 right before the next one.
+ */
+float timestep_alpha();
+
+
+/**
+ * @brief Returns the number of ticks dropped by the max_updates clamp since startup.
+ * @return The dropped tick count.
+ */
+Uint64 timestep_dropped();
+
+#endif
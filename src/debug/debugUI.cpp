@@ -42,7 +42,7 @@ void show_selected_ent() {
     }
     ImGui::Begin("Entity");
     ImGui::Text("ID: %d", selected_entity->id);
-    ImGui::Text("Sprite: %s", selected_entity->sprite.sprite_name.c_str());
+    ImGui::Text("Sprite: %s", selected_entity->sprite->sprite_name.c_str());
     ImGui::Text("Image Index: %d", selected_entity->image_index);
     ImGui::Text("Color Blend: %.2f, %.2f, %.2f, %.2f", 
         selected_entity->c_blend.r,
@@ -0,0 +1,391 @@
+#include "atlas.hpp"
+#include "../utils/util.hpp"
+#include <SDL3/SDL.h>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ATLAS_SSE2
+#endif
+using namespace Eigen;
+
+#define Skyline Vector2i
+
+
+static void grow_used(Atlas_page& page, int right, int bottom) {
+    if (page.used.x() < right) page.used.x() = right;
+    if (page.used.y() < bottom) page.used.y() = bottom;
+}
+
+
+// Skyline bottom-left
+static bool skyline_pack(Atlas_page& page, const Vector2i size, Vector2i& out) {
+    std::vector<Skyline>& skylines = page.skylines;
+    Uint16 skyline_count = skylines.size();
+    Uint16 max_w = page.width;
+    Uint16 max_h = page.height;
+    Uint16 w = size.x();
+    Uint16 h = size.y();
+
+    // Best candiate attributes
+    Uint16 best_idx     = UINT16_MAX;
+    Uint16 best_idx2    = UINT16_MAX;
+    Uint16 bestX        = UINT16_MAX;
+    Uint16 bestY        = UINT16_MAX;
+
+    // For each skylines
+    for (int i = 0; i < skyline_count; i++) {
+        int x = skylines[i].x();
+        int y = skylines[i].y();
+
+        // If the current Skyline.x + requested Width Exceeds MAX_ATLAS_WIDTH, move on
+        if (x + w > max_w) break;
+        // We want the lowest Y possible
+        if (y >= bestY) continue;
+
+        // Raise Y to avoid overlaping skylines
+        Uint16 xMax = x + w;
+        Uint16 i2;
+
+        // Loop through all upcoming skylines relative to this current skyline point
+        for (i2 = i + 1; i2 < skyline_count; i2++) {        // stops at The index where the spriteSheet stops overlapping
+            if (xMax <= skylines[i2].x()) break;            // Check to see if Bottom Right and other ahead point is overlapping
+            if (y < skylines[i2].y()) y = skylines[i2].y(); // We are looking for the Peakest Overlapping Skyline
+        }
+
+        // Don't get higher than the bestY or Max height(Atlas)
+        if (y >= bestY || y + h > max_h)
+            continue;
+
+        best_idx = i;
+        best_idx2 = i2;
+        bestX = x;
+        bestY = y;
+    }
+
+    // No Space to add
+    if (best_idx == UINT16_MAX) return false;
+
+    // Update Skyline silhouette
+    Vector2i TL, BR;
+    TL.x() = bestX;
+    TL.y() = bestY + h;
+    BR.x() = bestX + w;
+    BR.y() = skylines[best_idx2 - 1].y();
+    bool bBottomRight = (best_idx2 < skyline_count ? BR.x() < skylines[best_idx2].x() : BR.x() < max_w);
+
+    // Clean up overlapped skylines
+    if (best_idx2 > best_idx + 1)
+        skylines.erase(skylines.begin() + best_idx + 1, skylines.begin() + best_idx2);
+
+    skylines[best_idx] = TL;
+    if (bBottomRight)
+        skylines.insert(skylines.begin() + best_idx + 1, BR);
+
+    out.x() = bestX;
+    out.y() = bestY;
+    return true;
+}
+
+
+static bool rect_contains(const SDL_Rect& a, const SDL_Rect& b) {
+    return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+}
+
+
+// Drops free rects fully covered by another one
+static void prune_free_rects(std::vector<SDL_Rect>& free_rects) {
+    for (size_t i = 0; i < free_rects.size(); i++) {
+        for (size_t j = i + 1; j < free_rects.size(); j++) {
+            if (rect_contains(free_rects[j], free_rects[i])) {
+                free_rects.erase(free_rects.begin() + i);
+                i--;
+                break;
+            }
+            if (rect_contains(free_rects[i], free_rects[j])) {
+                free_rects.erase(free_rects.begin() + j);
+                j--;
+            }
+        }
+    }
+}
+
+
+// MaxRects, best short side fit
+static bool maxrects_pack(Atlas_page& page, const Vector2i size, Vector2i& out) {
+    std::vector<SDL_Rect>& free_rects = page.free_rects;
+    int w = size.x();
+    int h = size.y();
+
+    int best = -1;
+    int best_short = INT32_MAX;
+    int best_long = INT32_MAX;
+    for (size_t i = 0; i < free_rects.size(); i++) {
+        const SDL_Rect& fr = free_rects[i];
+        if (fr.w < w || fr.h < h) continue;
+
+        int left_w = fr.w - w;
+        int left_h = fr.h - h;
+        int short_side = SDL_min(left_w, left_h);
+        int long_side = SDL_max(left_w, left_h);
+        if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+            best = i;
+            best_short = short_side;
+            best_long = long_side;
+        }
+    }
+
+    // No Space to add
+    if (best == -1) return false;
+    SDL_Rect placed = {free_rects[best].x, free_rects[best].y, w, h};
+
+    // Split every free rect overlapping the placed one into its (up to 4) leftovers
+    size_t count = free_rects.size();
+    for (size_t i = 0; i < count; i++) {
+        SDL_Rect fr = free_rects[i];
+        if (!SDL_HasRectIntersection(&fr, &placed)) continue;
+
+        if (placed.x > fr.x)
+            free_rects.push_back({fr.x, fr.y, placed.x - fr.x, fr.h});                                 // Left
+        if (placed.x + placed.w < fr.x + fr.w)
+            free_rects.push_back({placed.x + placed.w, fr.y, fr.x + fr.w - placed.x - placed.w, fr.h});  // Right
+        if (placed.y > fr.y)
+            free_rects.push_back({fr.x, fr.y, fr.w, placed.y - fr.y});                                 // Top
+        if (placed.y + placed.h < fr.y + fr.h)
+            free_rects.push_back({fr.x, placed.y + placed.h, fr.w, fr.y + fr.h - placed.y - placed.h});  // Bottom
+
+        free_rects.erase(free_rects.begin() + i);
+        i--;
+        count--;
+    }
+    prune_free_rects(free_rects);
+
+    out.x() = placed.x;
+    out.y() = placed.y;
+    return true;
+}
+
+
+void atlas_page_init(Atlas_page& page, Atlas_packer packer, int width, int height) {
+    atlas_page_destroy(page);
+    page = Atlas_page{};
+    page.packer = packer;
+    page.width = width;
+    page.height = height;
+
+    page.skylines.push_back({0, 0});                // Flat ground
+    page.free_rects.push_back({0, 0, width, height});
+    page.surface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+}
+
+
+bool atlas_page_pack(Atlas_page& page, const Vector2i size, Vector2i& out) {
+    if (size.x() <= 0 || size.y() <= 0 || size.x() > page.width || size.y() > page.height)
+        return false;
+
+    bool packed = (page.packer == ATLAS_SKYLINE) ? skyline_pack(page, size, out) : maxrects_pack(page, size, out);
+    if (!packed) return false;
+
+    grow_used(page, out.x() + size.x(), out.y() + size.y());
+    page.packed_area += (Uint64)size.x() * size.y();
+    return true;
+}
+
+
+bool atlas_page_pack_all(Atlas_page& page, const std::vector<Vector2i>& sizes, std::vector<Vector2i>& out) {
+    // Tallest first packs tighter, results still land in the caller's order
+    std::vector<int> order(sizes.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return sizes[a].y() > sizes[b].y();
+    });
+
+    // Packs into a copy so a partial fit can be dropped, surface and texture stay shared
+    Atlas_page trial = page;
+    out.resize(sizes.size());
+    for (int i : order) {
+        if (!atlas_page_pack(trial, sizes[i], out[i])) return false;
+    }
+
+    page = std::move(trial);
+    return true;
+}
+
+
+// Joins free rects sharing a whole edge, freed neighbours become one bigger rect again
+static void merge_free_rects(std::vector<SDL_Rect>& free_rects) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < free_rects.size() && !merged; i++) {
+            for (size_t j = i + 1; j < free_rects.size(); j++) {
+                SDL_Rect& a = free_rects[i];
+                const SDL_Rect& b = free_rects[j];
+
+                if (a.y == b.y && a.h == b.h && (a.x + a.w == b.x || b.x + b.w == a.x)) {
+                    a.x = SDL_min(a.x, b.x);
+                    a.w += b.w;
+                }
+                else if (a.x == b.x && a.w == b.w && (a.y + a.h == b.y || b.y + b.h == a.y)) {
+                    a.y = SDL_min(a.y, b.y);
+                    a.h += b.h;
+                }
+                else continue;
+
+                free_rects.erase(free_rects.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+
+void atlas_page_free(Atlas_page& page, const SDL_Rect& rect) {
+    if (page.packer != ATLAS_MAXRECTS) {
+        SDL_Log("Only MaxRects pages can free rects.");
+        return;
+    }
+
+    page.packed_area -= (Uint64)rect.w * rect.h;
+    if (page.packed_area == 0) {                    // Empty again, drop the fragments
+        page.free_rects.assign(1, SDL_Rect{0, 0, page.width, page.height});
+        return;
+    }
+
+    page.free_rects.push_back(rect);
+    merge_free_rects(page.free_rects);
+    prune_free_rects(page.free_rects);
+}
+
+
+void atlas_page_destroy(Atlas_page& page) {
+    if (page.surface) SDL_DestroySurface(page.surface);
+    if (page.texture) SDL_DestroyTexture(page.texture);
+    for (SDL_Texture*& mip : page.mips) {
+        if (mip) SDL_DestroyTexture(mip);
+        mip = nullptr;
+    }
+    page.surface = nullptr;
+    page.texture = nullptr;
+}
+
+
+static Uint32* pixel_at(SDL_Surface* surface, int x, int y) {
+    return (Uint32*)((Uint8*)surface->pixels + y * surface->pitch) + x;
+}
+
+
+void atlas_blit(SDL_Surface* src, const SDL_Rect& src_rect, SDL_Surface* dst, Vector2i pos, int padding) {
+    int w = src_rect.w;
+    int h = src_rect.h;
+
+    // Raw row copies, both surfaces are RGBA32
+    for (int row = 0; row < h; row++) {
+        memcpy(pixel_at(dst, pos.x(), pos.y() + row), pixel_at(src, src_rect.x, src_rect.y + row), w * 4);
+    }
+    if (padding <= 0) return;
+
+    // Left and right columns
+    for (int row = 0; row < h; row++) {
+        Uint32* line = pixel_at(dst, pos.x(), pos.y() + row);
+        for (int p = 1; p <= padding; p++) {
+            line[-p] = line[0];
+            line[w - 1 + p] = line[w - 1];
+        }
+    }
+
+    // Top and bottom rows, corners included
+    int full_w = (w + padding * 2) * 4;
+    Uint32* top = pixel_at(dst, pos.x() - padding, pos.y());
+    Uint32* bottom = pixel_at(dst, pos.x() - padding, pos.y() + h - 1);
+    for (int p = 1; p <= padding; p++) {
+        memcpy(pixel_at(dst, pos.x() - padding, pos.y() - p), top, full_w);
+        memcpy(pixel_at(dst, pos.x() - padding, pos.y() + h - 1 + p), bottom, full_w);
+    }
+}
+
+
+// Rounding average, the same as _mm_avg_epu8
+static inline Uint8 avg_u8(Uint8 a, Uint8 b) {
+    return (Uint8)((a + b + 1) >> 1);
+}
+
+
+SDL_Surface* atlas_downscale(const SDL_Surface* src) {
+    int w = (src->w + 1) / 2;
+    int h = (src->h + 1) / 2;
+    SDL_Surface* dst = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGBA32);
+    if (dst == nullptr) return nullptr;
+
+    for (int y = 0; y < h; y++) {
+        const Uint8* row0 = (const Uint8*)src->pixels + (y * 2) * src->pitch;
+        const Uint8* row1 = (const Uint8*)src->pixels + SDL_min(y * 2 + 1, src->h - 1) * src->pitch;
+        Uint8* out = (Uint8*)dst->pixels + y * dst->pitch;
+        int x = 0;
+
+#ifdef ATLAS_SSE2
+        // 8 source pixels -> 4: average the two rows, then the even and odd columns
+        for (; (x + 4) * 2 <= src->w; x += 4) {
+            __m128i lo = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(row0 + x * 8)),
+                                      _mm_loadu_si128((const __m128i*)(row1 + x * 8)));
+            __m128i hi = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16)),
+                                      _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16)));
+            __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_si128((__m128i*)(out + x * 4), _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd)));
+        }
+#endif
+
+        for (; x < w; x++) {
+            int x0 = x * 2;
+            int x1 = SDL_min(x0 + 1, src->w - 1);
+            for (int c = 0; c < 4; c++) {
+                Uint8 left = avg_u8(row0[x0 * 4 + c], row1[x0 * 4 + c]);
+                Uint8 right = avg_u8(row0[x1 * 4 + c], row1[x1 * 4 + c]);
+                out[x * 4 + c] = avg_u8(left, right);
+            }
+        }
+    }
+    return dst;
+}
+
+
+SDL_Rect atlas_trim(SDL_Surface* src, const SDL_Rect& rect) {
+    int lo_x = rect.x + rect.w, lo_y = rect.y + rect.h;
+    int hi_x = rect.x - 1,      hi_y = rect.y - 1;
+
+    // RGBA32 is R, G, B, A in memory, alpha is the 4th byte of every pixel
+    for (int y = rect.y; y < rect.y + rect.h; y++) {
+        const Uint8* line = (const Uint8*)pixel_at(src, 0, y);
+        for (int x = rect.x; x < rect.x + rect.w; x++) {
+            if (line[x * 4 + 3] == 0) continue;
+            lo_x = SDL_min(lo_x, x);  hi_x = SDL_max(hi_x, x);
+            lo_y = SDL_min(lo_y, y);  hi_y = SDL_max(hi_y, y);
+        }
+    }
+
+    if (hi_x < lo_x) return SDL_Rect{rect.x, rect.y, 0, 0};
+    return SDL_Rect{lo_x, lo_y, hi_x - lo_x + 1, hi_y - lo_y + 1};
+}
+
+
+Uint64 atlas_hash_rect(SDL_Surface* src, const SDL_Rect& rect) {
+    Sint32 dims[2] = {rect.w, rect.h};
+    Uint64 hval = hash_bytes(dims, sizeof(dims));
+    for (int row = 0; row < rect.h; row++) {
+        hval = hash_bytes(pixel_at(src, rect.x, rect.y + row), rect.w * 4, hval);
+    }
+    return hval;
+}
+
+
+bool atlas_rect_equal(SDL_Surface* a, const SDL_Rect& rect, SDL_Surface* b, Vector2i pos) {
+    for (int row = 0; row < rect.h; row++) {
+        if (memcmp(pixel_at(a, rect.x, rect.y + row), pixel_at(b, pos.x(), pos.y() + row), rect.w * 4) != 0)
+            return false;
+    }
+    return true;
+}
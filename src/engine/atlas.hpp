@@ -0,0 +1,194 @@
+#ifndef ATLAS_HPP
+#define ATLAS_HPP
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#define MAX_ATLAS_SIZE 4096
+#define STREAM_ATLAS_SIZE 1024
+#define ATLAS_PADDING 2
+#define ATLAS_MIP_LEVELS 3          // Full, half and quarter resolution
+
+/**
+ * @brief Rectangle packing strategy used when building atlas pages.
+ */
+enum Atlas_packer {
+    ATLAS_SKYLINE,      /**< Skyline bottom-left, fast but leaves holes under tall neighbours. */
+    ATLAS_MAXRECTS      /**< MaxRects best-short-side-fit, tighter packing and supports freeing rects. */
+};
+
+/**
+ * @brief Order in which rectangles are fed to the packer.
+ */
+enum Atlas_sort {
+    ATLAS_SORT_NONE,    /**< File name order. */
+    ATLAS_SORT_HEIGHT,  /**< Tallest first, then widest. */
+    ATLAS_SORT_AREA     /**< Largest area first. */
+};
+
+/**
+ * @brief Options used when the atlas gets built.
+ */
+struct Atlas_settings {
+    Atlas_packer packer = ATLAS_MAXRECTS;   /**< The packing strategy. */
+    Atlas_sort sort = ATLAS_SORT_HEIGHT;    /**< The pre-sort heuristic. */
+    int padding = ATLAS_PADDING;            /**< Pixels around every rect, filled by extruding its edges. */
+    int page_size = MAX_ATLAS_SIZE;         /**< Width and height of a page while packing. */
+    int stream_page_size = STREAM_ATLAS_SIZE;   /**< Width and height of the pages sprites loaded after startup go into. */
+    bool mipmaps = true;                    /**< Generate half and quarter resolution copies of the startup pages for zoomed out cameras. */
+    Uint64 texture_budget = 0;              /**< Bytes of page textures (mips included) kept resident, 0 for no limit. */
+};
+
+/**
+ * @brief Packing results, for the log and the debug UI.
+ */
+struct Atlas_stats {
+    int page_count;         /**< Number of pages built. */
+    float occupancy;        /**< Packed pixels / page pixels, in percent. */
+    double pack_ms;         /**< Time spent packing and blitting. */
+    float trim_saved;       /**< Frame pixels dropped by trimming transparent borders, in percent. */
+    Uint64 dedup_bytes;     /**< RGBA bytes not stored because an identical frame was already in the atlas. */
+    Uint64 resident_bytes;  /**< Bytes of page textures currently on the GPU. */
+    int resident_pages;     /**< Pages with a texture, the others are evicted. */
+    Uint32 evictions;       /**< Pages evicted to stay under the texture budget. */
+    Uint32 restores;        /**< Evicted pages uploaded again because they were drawn. */
+};
+
+/**
+ * @brief One texture of the atlas with its packer state.
+ *
+ * Pages are packed inside a page_size square and cropped down to 'used'
+ * when they get uploaded, 'size' is the final texture size UVs refer to.
+ * Streaming pages are never cropped, they keep free space for sprites
+ * loaded at runtime and are updated one sub-rectangle at a time.
+ * Startup pages can also get downscaled copies (mips), their size is kept a
+ * multiple of 4 so every level maps the same UVs to the same pixels.
+ */
+struct Atlas_page {
+    Atlas_packer packer;
+    int width;                          /**< Packing area width. */
+    int height;                         /**< Packing area height. */
+    Vector2i used = {0, 0};             /**< Bottom-right extent of everything packed so far. */
+    Vector2i size = {0, 0};             /**< Texture size, set on upload. */
+    Uint64 packed_area = 0;             /**< Sum of the packed rect areas. */
+    bool streaming = false;             /**< Runtime page (always ATLAS_MAXRECTS, rects can be freed). */
+    std::vector<Vector2i> skylines;     /**< Skyline silhouette (ATLAS_SKYLINE). */
+    std::vector<SDL_Rect> free_rects;   /**< Maximal free rectangles (ATLAS_MAXRECTS). */
+    SDL_Surface* surface = nullptr;     /**< CPU pixels while the page is being built. */
+    SDL_Texture* texture = nullptr;     /**< GPU copy of the page. */
+    SDL_Texture* mips[ATLAS_MIP_LEVELS - 1] = {};   /**< Half and quarter resolution textures, nullptr until generated. */
+    bool mips_stale = false;            /**< Pixels changed after the mips were requested, they are not used anymore. */
+    Uint64 last_used = 0;               /**< Last frame the page was drawn in, for LRU eviction. */
+    const Uint8* backing = nullptr;     /**< The page's pixels in the mapped sprite pack, only such pages can be evicted. */
+    int backing_pitch = 0;              /**< Bytes per row of 'backing'. */
+};
+
+
+/**
+ * @brief Resets a page to an empty packing area and allocates its build surface.
+ * @param page The page to initialize.
+ * @param packer The packing strategy.
+ * @param width Packing area width.
+ * @param height Packing area height.
+ */
+void atlas_page_init(Atlas_page& page, Atlas_packer packer, int width, int height);
+
+
+/**
+ * @brief Finds room for a rectangle inside a page.
+ * @param page The page to pack into.
+ * @param size The size of the rectangle (padding included).
+ * @param out The top-left of the placed rectangle.
+ * @return False when the page has no room left.
+ */
+bool atlas_page_pack(Atlas_page& page, const Vector2i size, Vector2i& out);
+
+
+/**
+ * @brief Packs a group of rectangles into a page, all or nothing.
+ *
+ * Used for the frames of one sprite sheet so they always share a page.
+ * The page is left untouched when any of them does not fit.
+ *
+ * @param page The page to pack into.
+ * @param sizes The sizes of the rectangles (padding included).
+ * @param out The top-left of every placed rectangle, same order as sizes.
+ * @return False when the group does not fit.
+ */
+bool atlas_page_pack_all(Atlas_page& page, const std::vector<Vector2i>& sizes, std::vector<Vector2i>& out);
+
+
+/**
+ * @brief Gives a packed rectangle back to a page so it can be reused (ATLAS_MAXRECTS only).
+ * @param page The page the rectangle was packed into.
+ * @param rect The rectangle as it was packed (padding included).
+ */
+void atlas_page_free(Atlas_page& page, const SDL_Rect& rect);
+
+
+/**
+ * @brief Releases the CPU surface and the texture of a page.
+ * @param page The page to release.
+ */
+void atlas_page_destroy(Atlas_page& page);
+
+
+/**
+ * @brief Copies a region of an RGBA32 surface into an RGBA32 page surface and
+ *        extrudes its border pixels into the surrounding padding.
+ *
+ * Extrusion keeps bilinear filtering from sampling the neighbouring sprite.
+ *
+ * @param src The source surface.
+ * @param src_rect The region to copy.
+ * @param dst The destination surface.
+ * @param pos Where the region's top-left lands in dst (inside the padding).
+ * @param padding Pixels of extrusion on every side.
+ */
+void atlas_blit(SDL_Surface* src, const SDL_Rect& src_rect, SDL_Surface* dst, Vector2i pos, int padding);
+
+
+/**
+ * @brief Halves an RGBA32 surface with a 2x2 box filter (SSE2 when available).
+ *
+ * Odd sizes round up, the last column or row is averaged with itself.
+ * The SSE2 and scalar paths round the same way, so the output doesn't depend on the CPU.
+ *
+ * @param src The source surface.
+ * @return A new RGBA32 surface of half the size, nullptr when it can't be allocated.
+ */
+SDL_Surface* atlas_downscale(const SDL_Surface* src);
+
+
+/**
+ * @brief Shrinks a region of an RGBA32 surface to the bounds of its non-transparent pixels.
+ * @param src The source surface.
+ * @param rect The region to trim.
+ * @return The tight bounds in surface coordinates, w and h are 0 when the region is fully transparent.
+ */
+SDL_Rect atlas_trim(SDL_Surface* src, const SDL_Rect& rect);
+
+
+/**
+ * @brief Hashes the pixels of a region of an RGBA32 surface (its size included).
+ * @param src The source surface.
+ * @param rect The region to hash.
+ * @return The hash of the region.
+ */
+Uint64 atlas_hash_rect(SDL_Surface* src, const SDL_Rect& rect);
+
+
+/**
+ * @brief Compares a region of an RGBA32 surface against a same-sized region of another one.
+ *        Confirms hash matches, so colliding hashes never share a frame.
+ * @param a The first surface.
+ * @param rect The region of the first surface.
+ * @param b The second surface.
+ * @param pos Top-left of the region in the second surface.
+ * @return True when every pixel is identical.
+ */
+bool atlas_rect_equal(SDL_Surface* a, const SDL_Rect& rect, SDL_Surface* b, Vector2i pos);
+
+#endif
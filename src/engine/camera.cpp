@@ -9,20 +9,28 @@ float& cam_culling_margin() {
     return culling_margin;
 }
 
+Camera camera_lerp(const Camera& prev, const Camera& current, float alpha) {
+    Camera cam = current;
+    cam.position = prev.position + (current.position - prev.position) * alpha;
+    cam.zoom = prev.zoom + (current.zoom - prev.zoom) * alpha;
+    cam.rotation = prev.rotation + (current.rotation - prev.rotation) * alpha;
+    return cam;
+}
+
 void world_to_screen_ref(const Camera& cam, Vector2f& world_position) {
-    world_position - cam.position;
+    world_position = world_to_screen(cam, world_position);
 }
 
 Vector2f world_to_screen(const Camera& cam, Vector2f const world_position) {
-    return world_position - cam.position;
+    return cam.view() * world_position + cam.viewport_pos;
 }
 
 void screen_to_world_ref(const Camera& cam, Vector2f& screen_position) {
-    screen_position + cam.position;
+    screen_position = screen_to_world(cam, screen_position);
 }
 
 Vector2f screen_to_world(const Camera& cam, Vector2f const screen_position) {
-    return screen_position + cam.position;
+    return cam.view().inverse(Affine) * (screen_position - cam.viewport_pos);
 }
 
 // Return True is given position is seen inside the camera view
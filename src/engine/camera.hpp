@@ -2,12 +2,16 @@
 #define CAMERA_HPP
 
 #include "geometry.hpp"
+#include "../utils/util.hpp"
 #include "Eigen/Dense"
 using namespace Eigen;
 
 struct Camera {
-    Vector2f position;  /**< The top-left position of the camera in world coordinates. */
+    Vector2f position;  /**< The top-left position of the camera in world coordinates (at zoom 1, no rotation). */
     Vector2f size;      /**< The size (width, height) of the camera viewport. */
+    float zoom = 1;                     /**< Scale factor, > 1 zooms in. */
+    float rotation = 0;                 /**< Rotation in degrees around the view center. */
+    Vector2f viewport_pos = {0, 0};     /**< Top-left of the viewport inside the window (split screen, minimap). */
 
     /**
      * @brief Gets the x-coordinate of the camera position.
@@ -34,20 +38,57 @@ struct Camera {
     }
 
     /**
-     * @brief Gets the Top-left and Bottom-right of this camera
-     * @return the Bbox in a Vector4f Format (x, y, z, w)
+     * @brief Gets the world position the camera looks at.
+     * @return The view center in world coordinates.
+     */
+    Vector2f center() const {
+        return position + size / 2;
+    }
+
+    /**
+     * @brief Builds the 2x3 view matrix of this camera.
+     * 
+     * Maps world coordinates to viewport-local screen coordinates:
+     * screen = size / 2 + zoom * R(-rotation) * (world - center)
+     * @return The view transform.
+     */
+    Affine2f view() const {
+        Affine2f matx = Affine2f::Identity();
+        matx.translate(size / 2);
+        matx.rotate(-deg_to_rad(rotation));
+        matx.scale(zoom);
+        matx.translate(-center());
+        return matx;
+    }
+
+    /**
+     * @brief Gets the world-space bounds of the (rotated, zoomed) view.
+     * @return the axis-aligned Bbox around the view in a Vector4f Format (x, y, z, w)
      */
     Vector4f bbox() const {
-        return {
-            position.x(), 
-            position.y(),
-            position.x() + size.x(), 
-            position.y() + size.y()
+        Affine2f inv = view().inverse(Affine);
+        Vector2f corners[4] = {
+            inv * Vector2f(0, 0),
+            inv * Vector2f(size.x(), 0),
+            inv * size,
+            inv * Vector2f(0, size.y())
         };
+
+        Vector2f lo = corners[0], hi = corners[0];
+        for (const Vector2f& c : corners) {
+            lo = lo.cwiseMin(c);
+            hi = hi.cwiseMax(c);
+        }
+        return {lo.x(), lo.y(), hi.x(), hi.y()};
     }
 };
 
 
+/**
+ * Screen coordinates are window coordinates, they include the camera's viewport_pos.
+ */
+
+
 /**
  * @brief Transforms a world position to screen coordinates (in-place).
  * @param cam The camera to use for transformation.
@@ -82,6 +123,16 @@ void screen_to_world_ref(const Camera& cam, Vector2f& screen_position);
 Vector2f screen_to_world(const Camera& cam, Vector2f const screen_position);
 
 
+/**
+ * @brief Blends two states of a camera (position, zoom and rotation), for render interpolation.
+ * @param prev The camera at the previous simulation tick.
+ * @param current The camera at the latest simulation tick, the rest is copied from it.
+ * @param alpha 0 gives 'prev', 1 gives 'current'.
+ * @return The blended camera.
+ */
+Camera camera_lerp(const Camera& prev, const Camera& current, float alpha);
+
+
 /**
  * @brief Returns a reference to the culling margin value for all cameras.
  * @return Reference to the integer culling margin.
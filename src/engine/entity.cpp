@@ -1,94 +1,130 @@
 #include "sprite.hpp"
 #include "entity.hpp"
-#include <map>
 #include <string>
 #include <Eigen/Dense>
-#include <functional>
 using namespace Eigen;
 
-// Ent_ID, EntityData
-static std::unordered_map<Uint16, Entity> entity_map;
-static Uint32 id_cursor = 0;
+// Slots never move, ids are slot indices and 'live' packs the used ones for iteration
+struct Entity_pool {
+    Entity slots[MAX_ENTITIES];
+    Entity* live[MAX_ENTITIES];         // Dense, swap-removed on destroy
+    Uint16 live_index[MAX_ENTITIES];    // Slot -> position in 'live'
+    Uint16 free_ids[MAX_ENTITIES];      // Stack, the lowest id on top
+    Uint16 live_count = 0;
+    Uint16 free_count = 0;
+    bool resolved = false;              // Sprites are looked up on spawn
+};
+
+static Arena default_arena;
+static Entity_pool* default_pool = nullptr;
+static thread_local Entity_pool* bound_pool = nullptr;
+static Uint64 anim_clock = 0;
+
+
+Uint64& entity_anim_clock() {
+    return anim_clock;
+}
 
-// Return the assigned ID for this entity
-int entity_spawn(const std::string& sprite_name, Vector2f pos, Vector2f scale, float rotation, Uint16 depth) {
-    if (entity_map.size() >= MAX_ENTITIES) {
-        return -1;
+
+Entity_pool* entity_pool_create(Arena& arena) {
+    Entity_pool* pool = arena_new<Entity_pool>(arena);
+    for (int i = 0; i < MAX_ENTITIES; i++) {
+        pool->free_ids[i] = MAX_ENTITIES - 1 - i;
     }
+    pool->free_count = MAX_ENTITIES;
+    return pool;
+}
+
+
+void entity_pool_resolve(Entity_pool* pool) {
+    for (Uint16 i = 0; i < pool->live_count; i++) {
+        Entity& ent = *pool->live[i];
+        ent.sprite = &sprite_get(ent.sprite_id);
+        ent.anim_start = anim_clock;
+    }
+    pool->resolved = true;
+}
 
-    Uint64 spr_id = hash_string(sprite_name);
-    Entity ent = {};
-    ent.id = id_cursor;
-    ent.depth = depth;
-    ent.position = pos;
-    ent.rotation = rotation;
-    ent.scale = scale;
-    ent.sprite = sprite_get(spr_id);
-    ent.image_index = 0;
-    entity_map[id_cursor] = ent; 
 
-    return id_cursor++;
+void entity_bind_pool(Entity_pool* pool) {
+    bound_pool = pool;
+}
+
+
+// Entities spawned before any scene go to a pool of their own
+static Entity_pool& pool() {
+    if (bound_pool != nullptr) return *bound_pool;
+    if (default_pool == nullptr) {
+        default_pool = entity_pool_create(default_arena);
+        default_pool->resolved = true;
+    }
+    return *default_pool;
+}
+
+// Return the assigned ID for this entity
+int entity_spawn(std::string_view sprite_name, Vector2f pos, Vector2f scale, float rotation, Uint16 depth) {
+    return entity_spawn(sprite_name, pos, scale, rotation, TOP_LEFT, depth);
 }
 
 // Return the assigned ID for this entity
-int entity_spawn(const std::string& sprite_name, Vector2f pos, Vector2f scale, float rotation, Pivot_Type pivot, Uint16 depth) {
-    if (entity_map.size() >= MAX_ENTITIES) {
+int entity_spawn(std::string_view sprite_name, Vector2f pos, Vector2f scale, float rotation, Pivot_Type pivot, Uint16 depth) {
+    Entity_pool& p = pool();
+    if (p.free_count == 0) {
         return -1;
     }
 
-    Entity ent = {};
-    Uint64 spr_id = hash_string(sprite_name);
+    Uint16 id = p.free_ids[--p.free_count];
+    Entity& ent = p.slots[id];
+    ent = Entity{};
     ent.pivot = pivot;
-    ent.id = id_cursor;
+    ent.id = id;
     ent.depth = depth;
     ent.position = pos;
     ent.rotation = rotation;
     ent.scale = scale;
-    ent.sprite = sprite_get(spr_id);
+    ent.sprite_id = hash_string(sprite_name);
+    ent.sprite = p.resolved ? &sprite_get(ent.sprite_id) : nullptr;
     ent.image_index = 0;
-    entity_map[id_cursor] = ent; 
+    ent.anim_start = p.resolved ? anim_clock : 0;
+    ent.snapshot();             // Nothing to blend from yet
 
-    return id_cursor++;
+    p.live_index[id] = p.live_count;
+    p.live[p.live_count++] = &ent;
+    return id;
 }
 
 
-void entity_destroy(Uint16 id) {
-    entity_map.erase(id);
+void entity_snapshot_all() {
+    for (Entity& ent : entity_all()) {
+        ent.snapshot();
+    }
 }
 
 
-// Bad Performance shit from here
-/*
-void entity_render_all(SDL_Renderer* rend, Camera &cam) {
-    if (entity_map.empty()) return;
-
-    for (auto& [key, value] : entity_map) {
-        // Check if at least one vertex is inside the camera view
-        bool is_visible = false;
-        for (const auto& vertex : value.vertices()) {
-            if (!camera_is_position_out(cam, vertex)) {
-                is_visible = true;
-                break;
-            }
-        }
-
-        if (is_visible) {
-            value.render(rend, cam);
-        }
-    }
+void entity_destroy(Uint16 id) {
+    Entity_pool& p = pool();
+    if (id >= MAX_ENTITIES) return;
+    Uint16 at = p.live_index[id];
+    if (at >= p.live_count || p.live[at] != &p.slots[id]) return;     // Not alive
+
+    Entity* last = p.live[--p.live_count];
+    p.live[at] = last;
+    p.live_index[last->id] = at;
+    p.free_ids[p.free_count++] = id;
 }
-*/
 
 
 Entity& entity_get(Uint16 id) {
-    return entity_map[id];
+    return pool().slots[id];
 }
 
 
 int entity_count() {
-    return entity_map.size();
+    return pool().live_count;
 }
 
-std::unordered_map<Uint16, Entity>& entity_get_map() {
-    return entity_map;
-}
\ No newline at end of file
+
+Entity_range entity_all() {
+    Entity_pool& p = pool();
+    return {p.live, p.live + p.live_count};
+}
@@ -6,6 +6,7 @@
 #include "renderer.hpp"
 
 #include "../utils/util.hpp"
+#include "../utils/arena.hpp"
 #include <Eigen/Dense>
 #include <functional>
 #include <array>
@@ -13,6 +14,17 @@
 using namespace Eigen;
 static const Uint16 MAX_ENTITIES = 1000;
 
+
+/**
+ * @brief Returns a reference to the global animation clock, in milliseconds.
+ * 
+ * Set it once per frame before evaluating animations. Entities spawned later start
+ * their animation at the clock's value.
+ * @return Reference to the clock.
+ */
+Uint64& entity_anim_clock();
+
+
 /**
  * @brief Represents a game entity with transform, sprite, and rendering data.
  * 
@@ -24,11 +36,12 @@ private:
     Affine2f matx = Affine2f::Identity();
 
 public:
-    int id;                          /**< The index location in the entity array. */
+    int id;                          /**< The slot of this entity in its pool. */
     Pivot_Type pivot = TOP_LEFT;     /**< The point where position rests, defaults to TOP_LEFT. */
-    Sprite_sheet_data sprite;        /**< The sprite sheet to refer to. */
-    Uint8 image_index;               /**< The current frame of the sprite. */
-    Uint64 last_frame_time;          /**< Tracking time for FPS. */
+    Uint64 sprite_id;                /**< The HashID of the sprite sheet. */
+    const Sprite_sheet_data* sprite; /**< The sprite sheet to refer to (owned by the sprite manager, follows hot reloads), nullptr until the pool is resolved. */
+    Uint8 image_index;               /**< The current frame of the sprite, evaluated by update_frame. */
+    Uint64 anim_start;               /**< Animation clock value the animation started at. */
     std::array<Vector2f, 4> vertices;               /**< Original points of this entity (no rotation/scale). */
     std::array<Vector2f, 4> transformed_vertices;   /**< Vertices with applied rotation and scale. */
     SDL_FColor c_blend = {1, 1, 1, 1};              /**< Optional Color blending option, defaults to White*/
@@ -39,6 +52,11 @@ public:
     Vector2f scale;                  /**< Scale factor. */
     float rotation;                  /**< Rotation in degrees. */
 
+    // Transform at the previous simulation tick, rendering blends it with the current one
+    Vector2f prev_position;          /**< World position at the previous tick. */
+    Vector2f prev_scale;             /**< Scale factor at the previous tick. */
+    float prev_rotation;             /**< Rotation at the previous tick. */
+
 
     /**
      * @brief Get's the Bounding box of this entity, (transformed)
@@ -54,12 +72,23 @@ public:
     }
 
     
+    /**
+     * @brief Returns the pivot offset of the current frame for a given size.
+     * @param size The untrimmed frame size, scaled or not.
+     */
+    Vector2f pivot_offset(const Vector2f& size) const {
+        if (pivot != SPRITE_PIVOT || image_index >= sprite->frames.size()) return get_pivot_offset(pivot, size);
+        Vector2f ratio = size.cwiseQuotient(sprite->frame_size.cast<float>());
+        return sprite->frames[image_index].pivot.cast<float>().cwiseProduct(ratio);
+    }
+
+
     /**
      * @brief Updates the entity's vertex positions based on position, and pivot.
      */
     void update_vertices() {
-        Vector2f size = Vector2f{sprite.frame_size.x(), sprite.frame_size.y()};
-        Vector2f offset = get_pivot_offset(pivot, size);
+        Vector2f size = Vector2f{sprite->frame_size.x(), sprite->frame_size.y()};
+        Vector2f offset = pivot_offset(size);
         vertices[0] = Vector2f(position.x() - offset.x(), position.y() - offset.y());   // Top-left
         vertices[1] = Vector2f(position.x() + offset.x(), position.y() - offset.y());   // Top-right
         vertices[2] = Vector2f(position.x() + offset.x(), position.y() + offset.y());   // Bottom-right
@@ -68,38 +97,80 @@ public:
 
 
     /**
-     * @brief Updates the animation frame based on elapsed time.
-     * @param now The current time in milliseconds.
+     * @brief Evaluates the animation frame from the animation clock and the sprite's timeline.
+     *        Stateless, so it only needs to run for entities that get drawn.
+     * @param clock The animation clock in milliseconds (see entity_anim_clock).
      */
-    void update_frame(Uint16 now) {
-        if ((now - last_frame_time) >= (1000.0f / sprite.fps)) {
-            image_index = (image_index + 1) % sprite.frame_count;
-            last_frame_time = now;
-        }
+    void update_frame(Uint64 clock) {
+        image_index = sprite->frame_at(clock > anim_start ? clock - anim_start : 0);
     }
 
+
     /**
-     * @brief Applies transformation and submits the entity's vertices for rendering.
-     * @param cam Reference to the camera for rendering transformations.
+     * @brief Restarts the animation from its first frame.
      */
-    void submit_vertices(const Camera& cam) {
-        render_batch_entity(*this, cam);
+    void restart_animation() {
+        anim_start = entity_anim_clock();
+    }
+
+
+    /**
+     * @brief Conservative visibility test, whatever its frame or rotation the quad stays within
+     *        twice the frame diagonal of 'position' (for pivots inside the frame).
+     * @param box World space area [Top-Left, Bottom-Right].
+     * @return False when the entity can't overlap the area.
+     */
+    bool may_overlap(const Vector4f& box) const {
+        Vector2f size = scale.cwiseAbs().cwiseProduct(sprite->frame_size.cast<float>());
+        float reach = 2 * size.norm();
+        return position.x() + reach >= box.x() && position.x() - reach <= box.z() &&
+               position.y() + reach >= box.y() && position.y() - reach <= box.w();
+    }
+
+    /**
+     * @brief Submits the entity's transformed (world) vertices for rendering.
+     *        Cameras cull and transform them later, in render_batch_all.
+     */
+    void submit_vertices() {
+        render_batch_entity(*this);
+    }
+
+    /**
+     * @brief Saves the transform as the previous tick's, call before every simulation update.
+     */
+    void snapshot() {
+        prev_position = position;
+        prev_scale = scale;
+        prev_rotation = rotation;
     }
 
     /**
      * @brief Applies rotation, scale, and pivot offset to the entity's vertices.
+     * @param alpha Blend between the previous tick's transform (0) and the current one (1).
      */
-    void apply_transform() {
+    void apply_transform(float alpha = 1.0f) {
+        Vector2f position = prev_position + (this->position - prev_position) * alpha;
+        Vector2f scale = prev_scale + (this->scale - prev_scale) * alpha;
+        float rotation = prev_rotation + (this->rotation - prev_rotation) * alpha;
 
-        Vector2f size = Vector2f{scale.x() * sprite.frame_size.x(), scale.y() * sprite.frame_size.y()};
-        Vector2f p_offset = get_pivot_offset(pivot, size);
+        Vector2f size = Vector2f{scale.x() * sprite->frame_size.x(), scale.y() * sprite->frame_size.y()};
+        Vector2f p_offset = pivot_offset(size);
         matx = Affine2f::Identity();
 
+        // The quad only covers the trimmed pixels of the current frame
+        Vector2f lo = {0, 0};
+        Vector2f hi = size;
+        if (image_index < sprite->frames.size()) {
+            const Sprite_frame& frame = sprite->frames[image_index];
+            lo = frame.offset.cast<float>().cwiseProduct(scale);
+            hi = (frame.offset + frame.size).cast<float>().cwiseProduct(scale);
+        }
+
         std::array<Vector2f, 4> center_p = {
-            Vector2f{0, 0},         // TL
-            Vector2f{size.x(), 0},  // TR
-            size,                   // BR
-            Vector2f{0, size.y()}   // BL
+            lo,                         // TL
+            Vector2f{hi.x(), lo.y()},   // TR
+            hi,                         // BR
+            Vector2f{lo.x(), hi.y()}    // BL
         };
         
         matx.translate(position);
@@ -117,6 +188,58 @@ public:
 };
 
 
+/**
+ * @brief Every entity of a scene, a fixed array of MAX_ENTITIES slots living in the scene's arena.
+ */
+struct Entity_pool;
+
+
+/**
+ * @brief Iterates the live entities of a pool, in no particular order.
+ */
+struct Entity_iterator {
+    Entity* const* at;
+    Entity& operator*() const { return **at; }
+    Entity_iterator& operator++() { ++at; return *this; }
+    bool operator!=(const Entity_iterator& other) const { return at != other.at; }
+};
+
+struct Entity_range {
+    Entity* const* first;
+    Entity* const* last;
+    Entity_iterator begin() const { return {first}; }
+    Entity_iterator end() const { return {last}; }
+};
+
+
+/**
+ * @brief Creates an entity pool inside an arena, it goes away when the arena is reset.
+ * 
+ * Entities spawned into a new pool don't look their sprite up yet, so a pool can be
+ * filled on a loading thread while the sprite manager is in use. entity_pool_resolve
+ * makes it usable for rendering.
+ * 
+ * @param arena The arena owning the pool.
+ * @return The pool.
+ */
+Entity_pool* entity_pool_create(Arena& arena);
+
+
+/**
+ * @brief Looks up the sprite of every entity of a pool and starts their animations.
+ *        Call on the main thread, entities spawned afterwards resolve right away.
+ * @param pool The pool.
+ */
+void entity_pool_resolve(Entity_pool* pool);
+
+
+/**
+ * @brief Makes every entity_* call of the calling thread use a pool.
+ * @param pool The pool, nullptr for the default one.
+ */
+void entity_bind_pool(Entity_pool* pool);
+
+
 /**
  * @brief Spawns a new entity with the given parameters.
  * 
@@ -127,7 +250,7 @@ public:
  * @param depth The rendering depth.
  * @return The ID of the spawned entity.
  */
-int entity_spawn(const std::string& sprite_name, Vector2f pos, Vector2f scale, float rotation, Uint16 depth);
+int entity_spawn(std::string_view sprite_name, Vector2f pos, Vector2f scale, float rotation, Uint16 depth);
 
 
 /**
@@ -141,7 +264,13 @@ int entity_spawn(const std::string& sprite_name, Vector2f pos, Vector2f scale, f
  * @param depth The rendering depth.
  * @return The ID of the spawned entity.
  */
-int entity_spawn(const std::string& sprite_name, Vector2f pos, Vector2f scale, float rotation, Pivot_Type pivot, Uint16 depth);
+int entity_spawn(std::string_view sprite_name, Vector2f pos, Vector2f scale, float rotation, Pivot_Type pivot, Uint16 depth);
+
+
+/**
+ * @brief Saves the transform of every entity as the previous tick's (see Entity::snapshot).
+ */
+void entity_snapshot_all();
 
 
 /**
@@ -167,8 +296,9 @@ int entity_count();
 
 
 /**
- * @brief Returns a reference to the map of all entities.
- * @return Reference to the unordered_map of entities.
+ * @brief Returns the live entities of the bound pool.
+ *        Spawning or destroying entities invalidates the range.
+ * @return The range, for range-based for loops.
  */
-std::unordered_map<Uint16, Entity>& entity_get_map();
+Entity_range entity_all();
 #endif
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "particle.hpp"
+#include "renderer.hpp"
+#include "sprite.hpp"
+#include <SDL3/SDL.h>
+#include <Eigen/Dense>
+#include <stdexcept>
+#include <vector>
+using namespace Eigen;
+
+/**
+ * Structure of arrays, one column per attribute so the update pass runs as
+ * plain Eigen array expressions (vectorized) over the first 'count' rows.
+ * Rows [count, capacity) are free, dead particles are swap-removed.
+ */
+struct Particle_pool {
+    Particle_emitter emitter;
+    bool used = false;
+    int count = 0;
+    float emit_accum = 0;           // Fractional particles carried over to the next update
+
+    ArrayXf pos_x, pos_y;
+    ArrayXf vel_x, vel_y;
+    ArrayXf life, inv_life;         // Remaining seconds, 1 / total lifetime
+    ArrayXf size;
+    ArrayXf col_r, col_g, col_b, col_a;
+    ArrayXi frame;
+};
+
+static Particle_pool pools[MAX_PARTICLE_EMITTERS];
+static std::vector<Vector4f> frame_boxes;   // Scratch, trimmed frame bounds of the sprite being submitted
+static ArrayXf age_scratch;                 // Scratch, normalized age of the pool being updated
+
+
+static float rand_range(float a, float b) {
+    return a + (b - a) * SDL_randf();
+}
+
+
+static void pool_spawn(Particle_pool& pool, int amount) {
+    const Particle_emitter& em = pool.emitter;
+    int frame_count = sprite_get(em.sprite_id).frame_count;
+    amount = SDL_min(amount, pool.emitter.capacity - pool.count);
+
+    for (int k = 0; k < amount; k++) {
+        int i = pool.count++;
+        float life = rand_range(em.life_min, em.life_max);
+
+        pool.pos_x[i]    = em.position.x() + rand_range(-em.spread.x(), em.spread.x());
+        pool.pos_y[i]    = em.position.y() + rand_range(-em.spread.y(), em.spread.y());
+        pool.vel_x[i]    = rand_range(em.velocity_min.x(), em.velocity_max.x());
+        pool.vel_y[i]    = rand_range(em.velocity_min.y(), em.velocity_max.y());
+        pool.life[i]     = life;
+        pool.inv_life[i] = (life > 0) ? 1.0f / life : 0.0f;
+        pool.size[i]     = em.size_start;
+        pool.col_r[i]    = em.color_start.r;
+        pool.col_g[i]    = em.color_start.g;
+        pool.col_b[i]    = em.color_start.b;
+        pool.col_a[i]    = em.color_start.a;
+        pool.frame[i]    = em.animate ? 0 : SDL_rand(frame_count);
+    }
+}
+
+
+// Moves the last live particle into slot i
+static void pool_swap_remove(Particle_pool& pool, int i) {
+    int last = --pool.count;
+    pool.pos_x[i]    = pool.pos_x[last];
+    pool.pos_y[i]    = pool.pos_y[last];
+    pool.vel_x[i]    = pool.vel_x[last];
+    pool.vel_y[i]    = pool.vel_y[last];
+    pool.life[i]     = pool.life[last];
+    pool.inv_life[i] = pool.inv_life[last];
+    pool.size[i]     = pool.size[last];
+    pool.col_r[i]    = pool.col_r[last];
+    pool.col_g[i]    = pool.col_g[last];
+    pool.col_b[i]    = pool.col_b[last];
+    pool.col_a[i]    = pool.col_a[last];
+    pool.frame[i]    = pool.frame[last];
+}
+
+
+static void pool_update(Particle_pool& pool, float dt) {
+    const Particle_emitter& em = pool.emitter;
+
+    if (em.active && em.rate > 0) {
+        pool.emit_accum += em.rate * dt;
+        int amount = (int)pool.emit_accum;
+        pool.emit_accum -= amount;
+        pool_spawn(pool, amount);
+    }
+
+    int n = pool.count;
+    if (n == 0) return;
+
+    // Integration
+    pool.vel_x.head(n) += em.gravity.x() * dt;
+    pool.vel_y.head(n) += em.gravity.y() * dt;
+    pool.pos_x.head(n) += pool.vel_x.head(n) * dt;
+    pool.pos_y.head(n) += pool.vel_y.head(n) * dt;
+
+    // Aging, t goes from 0 (birth) to 1 (death)
+    pool.life.head(n) -= dt;
+    if (age_scratch.size() < n) age_scratch.resize(em.capacity);
+    auto t = age_scratch.head(n);
+    t = (1.0f - pool.life.head(n) * pool.inv_life.head(n)).max(0.0f).min(1.0f);
+
+    pool.size.head(n)  = em.size_start + (em.size_end - em.size_start) * t;
+    pool.col_r.head(n) = em.color_start.r + (em.color_end.r - em.color_start.r) * t;
+    pool.col_g.head(n) = em.color_start.g + (em.color_end.g - em.color_start.g) * t;
+    pool.col_b.head(n) = em.color_start.b + (em.color_end.b - em.color_start.b) * t;
+    pool.col_a.head(n) = em.color_start.a + (em.color_end.a - em.color_start.a) * t;
+
+    if (em.animate) {
+        int frame_count = sprite_get(em.sprite_id).frame_count;
+        pool.frame.head(n) = (t * frame_count).cast<int>().min(frame_count - 1);
+    }
+
+    // Compaction, the swapped-in particle is checked again on the same index
+    int i = 0;
+    while (i < pool.count) {
+        if (pool.life[i] <= 0) pool_swap_remove(pool, i);
+        else i++;
+    }
+}
+
+
+int particle_emitter_add(const Particle_emitter& emitter) {
+    for (int id = 0; id < MAX_PARTICLE_EMITTERS; id++) {
+        Particle_pool& pool = pools[id];
+        if (pool.used) continue;
+
+        int cap = emitter.capacity;
+        pool.emitter = emitter;
+        pool.used = true;
+        pool.count = 0;
+        pool.emit_accum = 0;
+
+        pool.pos_x.resize(cap);    pool.pos_y.resize(cap);
+        pool.vel_x.resize(cap);    pool.vel_y.resize(cap);
+        pool.life.resize(cap);     pool.inv_life.resize(cap);
+        pool.size.resize(cap);
+        pool.col_r.resize(cap);    pool.col_g.resize(cap);
+        pool.col_b.resize(cap);    pool.col_a.resize(cap);
+        pool.frame.resize(cap);
+        return id;
+    }
+
+    SDL_Log("Particle emitter limit reached. {%d}", MAX_PARTICLE_EMITTERS);
+    return -1;
+}
+
+
+static bool valid_emitter(int id) {
+    return id >= 0 && id < MAX_PARTICLE_EMITTERS && pools[id].used;
+}
+
+
+Particle_emitter& particle_emitter_get(int id) {
+    if (!valid_emitter(id)) throw std::out_of_range("Particle emitter not found");
+    return pools[id].emitter;
+}
+
+
+void particle_emitter_remove(int id) {
+    if (!valid_emitter(id)) return;
+    pools[id] = Particle_pool{};
+}
+
+
+void particle_emit(int id, int count) {
+    if (!valid_emitter(id)) return;
+    pool_spawn(pools[id], count);
+}
+
+
+void particle_update(float dt) {
+    for (Particle_pool& pool : pools) {
+        if (pool.used) pool_update(pool, dt);
+    }
+}
+
+
+void particle_submit(const Vector4f& view_box) {
+    for (Particle_pool& pool : pools) {
+        if (!pool.used || pool.count == 0) continue;
+
+        const Sprite_sheet_data& spr = sprite_get(pool.emitter.sprite_id);
+        if (spr.frame_count == 0) continue;
+        int last_frame = spr.frame_count - 1;     // A reload may have dropped frames since they were rolled
+        Vector2f half = spr.frame_size.cast<float>() * 0.5f;
+
+        // Trimmed frame bounds relative to the frame center, at scale 1
+        frame_boxes.resize(spr.frame_count);
+        for (int f = 0; f < spr.frame_count; f++) {
+            const Sprite_frame& frame = spr.frames[f];
+            Vector2f lo = frame.offset.cast<float>() - half;
+            frame_boxes[f] = {lo.x(), lo.y(), lo.x() + frame.size.x(), lo.y() + frame.size.y()};
+        }
+
+        // Same bounds as the entity pass, layers that scroll differently can't be culled in world space
+        bool cull = render_depth_cullable(pool.emitter.depth);
+        SDL_Vertex* v = render_batch_quads_begin(pool.emitter.depth, pool.count, spr.page);
+        int written = 0;
+
+        for (int i = 0; i < pool.count; i++) {
+            float s = pool.size[i];
+            float x = pool.pos_x[i];
+            float y = pool.pos_y[i];
+            int f = SDL_min(pool.frame[i], last_frame);
+            const Vector4f& box = frame_boxes[f];
+            if (cull && (x + box.z() * s < view_box.x() || x + box.x() * s > view_box.z() ||
+                         y + box.w() * s < view_box.y() || y + box.y() * s > view_box.w())) continue;
+
+            SDL_FColor c = {pool.col_r[i], pool.col_g[i], pool.col_b[i], pool.col_a[i]};
+            const Vector4f& uv = spr.uvs[f];
+            v[0] = {{x + box.x() * s, y + box.y() * s}, c, {uv.x(), uv.y()}};    // Top left
+            v[1] = {{x + box.z() * s, y + box.y() * s}, c, {uv.z(), uv.y()}};    // Top right
+            v[2] = {{x + box.z() * s, y + box.w() * s}, c, {uv.z(), uv.w()}};    // Bottom right
+            v[3] = {{x + box.x() * s, y + box.w() * s}, c, {uv.x(), uv.w()}};    // Bottom left
+            v += 4;
+            written++;
+        }
+
+        render_batch_quads_end(pool.emitter.depth, written);
+    }
+}
+
+
+int particle_count() {
+    int total = 0;
+    for (const Particle_pool& pool : pools) {
+        total += pool.count;
+    }
+    return total;
+}
+
+
+void particle_cleanup() {
+    for (Particle_pool& pool : pools) {
+        pool = Particle_pool{};
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef PARTICLE_HPP
+#define PARTICLE_HPP
+
+#include <SDL3/SDL.h>
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#define MAX_PARTICLE_EMITTERS 64
+
+/**
+ * @brief Describes how an emitter spawns and animates its particles.
+ *
+ * Particles are not entities, they live in a fixed-capacity pool owned by the emitter
+ * and are written straight into the render batch of the emitter's depth.
+ */
+struct Particle_emitter {
+    Uint64 sprite_id;               /**< The sprite used for every particle quad. */
+    Uint16 depth = 100;             /**< Depth batch the particles are written into. */
+    int capacity = 1024;            /**< Pool size, spawns past this are dropped. */
+    float rate = 0;                 /**< Particles emitted per second, 0 = bursts only. */
+    Vector2f position = {0, 0};     /**< Emission origin in world coordinates. */
+    Vector2f spread = {0, 0};       /**< Random half-extent around the origin. */
+    Vector2f velocity_min = {0, 0}; /**< Lower bound of the initial velocity (pixels per second). */
+    Vector2f velocity_max = {0, 0}; /**< Upper bound of the initial velocity (pixels per second). */
+    Vector2f gravity = {0, 0};      /**< Constant acceleration (pixels per second²). */
+    float life_min = 1;             /**< Shortest lifetime in seconds. */
+    float life_max = 1;             /**< Longest lifetime in seconds. */
+    float size_start = 1;           /**< Scale of the sprite frame at birth. */
+    float size_end = 1;             /**< Scale of the sprite frame at death. */
+    SDL_FColor color_start = {1, 1, 1, 1};  /**< Color blend at birth. */
+    SDL_FColor color_end = {1, 1, 1, 0};    /**< Color blend at death. */
+    bool animate = true;            /**< Frame follows the particle age, otherwise a random frame is kept. */
+    bool active = true;             /**< Paused emitters stop emitting but keep simulating. */
+};
+
+
+/**
+ * @brief Adds an emitter and allocates its particle pool.
+ * @param emitter The emitter description (copied).
+ * @return The emitter ID, or -1 when MAX_PARTICLE_EMITTERS is reached.
+ */
+int particle_emitter_add(const Particle_emitter& emitter);
+
+
+/**
+ * @brief Retrieves the emitter description, e.g. to move it or change its rate.
+ *        Throws std::out_of_range for an unknown ID (e.g. the -1 of a failed add).
+ * @param id The emitter ID.
+ * @return Reference to the Particle_emitter.
+ */
+Particle_emitter& particle_emitter_get(int id);
+
+
+/**
+ * @brief Removes an emitter together with all of its live particles.
+ * @param id The emitter ID, invalid IDs are ignored.
+ */
+void particle_emitter_remove(int id);
+
+
+/**
+ * @brief Spawns a burst of particles from an emitter.
+ * @param id The emitter ID, invalid IDs are ignored.
+ * @param count Number of particles to spawn (clamped to the free pool space).
+ */
+void particle_emit(int id, int count);
+
+
+/**
+ * @brief Emits, integrates and ages all particles, dead ones are swap-removed.
+ * @param dt Elapsed simulation time in seconds.
+ */
+void particle_update(float dt);
+
+
+/**
+ * @brief Writes the particles overlapping a box as world-space quads into the render batches.
+ *        Particles on layers that scroll or are static are all written.
+ * @param view_box World bounds every camera can see {min_x, min_y, max_x, max_y}, margin included.
+ */
+void particle_submit(const Vector4f& view_box);
+
+
+/**
+ * @brief Returns the number of live particles across all emitters.
+ * @return The particle count.
+ */
+int particle_count();
+
+
+/**
+ * @brief Releases every emitter and particle pool.
+ */
+void particle_cleanup();
+
+#endif
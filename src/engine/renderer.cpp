@@ -3,6 +3,7 @@
 #include "camera.hpp"
 #include "entity.hpp"
 #include "sprite.hpp"
+#include "../utils/arena.hpp"
 
 #include <map>
 #include <bits/stdc++.h>
@@ -12,6 +13,24 @@ using namespace Eigen;
 
 static SDL_Renderer* renderer = nullptr;
 static std::map<Uint16, std::pair<VertexBuffer, VertexBuffer>> render_batches;  // Depth, <VertexBuffer(Textured), VertexBuffer(Primitive)>
+static std::vector<int> quad_index_pattern;                                   // Shared by every textured batch
+static std::vector<SDL_Vertex> discard;                                        // Sink for quads aimed at a baked static layer
+static std::map<Uint16, Render_layer> render_layers;                           // Depth, Layer
+
+// A baked layer as seen with one zoom and rotation, moved around with a translation only
+struct Baked_view {
+    Matrix2f linear = Matrix2f::Zero();     // View without its translation, the copy is rebuilt when it changes
+    Vector2f offset = {NAN, NAN};           // Translation currently added to 'vertices'
+    std::vector<SDL_Vertex> base;           // Textured quads then primitives, linear part applied once
+    std::vector<SDL_Vertex> vertices;       // 'base' moved by 'offset', what gets drawn
+    std::vector<Uint8> pages;               // Atlas page of each textured quad
+    int quad_verts = 0;
+    Uint64 last_used = 0;
+};
+static std::map<Uint16, std::array<Baked_view, 2>> baked_views;               // Depth, one per camera (view and minimap)
+static Uint64 draw_pass = 0;
+
+#define ANONYMOUS_TAG 0x80000000    // Sort tag bit for quads without an entity, they lose ties
 static int prev_rend_c = 0;
 static int rendered_c = 0;
 
@@ -21,167 +40,520 @@ void render_init(SDL_Renderer* rend) {
 }
 
 
-void render_submit_vertices(const SDL_Vertex vertices[], const std::vector<int>& indices, int vert_count, Uint16 depth, bool is_primitive) {
-    int idx_count = indices.size();
+static Render_layer* layer_at(Uint16 depth) {
+    auto it = render_layers.find(depth);
+    return (it == render_layers.end()) ? nullptr : &it->second;
+}
+
+
+// Baked static layers keep their cached buffer, new submissions are dropped
+static bool is_baked(Uint16 depth) {
+    Render_layer* layer = layer_at(depth);
+    return layer != nullptr && layer->baked;
+}
+
+
+bool render_depth_cullable(Uint16 depth) {
+    Render_layer* layer = layer_at(depth);
+    return layer == nullptr || (!layer->is_static && layer->scroll == Vector2f(1, 1));
+}
+
+
+static void bake_layer(Render_layer& layer, const std::pair<VertexBuffer, VertexBuffer>& batch) {
+    Vector2f lo = { FLT_MAX,  FLT_MAX};
+    Vector2f hi = {-FLT_MAX, -FLT_MAX};
+
+    for (const VertexBuffer* buf : {&batch.first, &batch.second}) {
+        for (int i = 0; i < buf->vert_count; i++) {
+            Vector2f p = {buf->vertices[i].position.x, buf->vertices[i].position.y};
+            lo = lo.cwiseMin(p);
+            hi = hi.cwiseMax(p);
+        }
+    }
+
+    layer.bounds = {lo.x(), lo.y(), hi.x(), hi.y()};
+    layer.baked = true;
+    baked_views.erase(layer.depth);
+}
+
+
+void render_layer_add(const std::string& name, Uint16 depth, Vector2f scroll, bool is_static) {
+    Render_layer& layer = render_layers[depth];
+    layer.name = name;
+    layer.depth = depth;
+    layer.scroll = scroll;
+    layer.is_static = is_static;
+    layer.baked = false;
+    baked_views.erase(depth);
+}
+
+
+Render_layer& render_layer_get(const std::string& name) {
+    for (auto& [depth, layer] : render_layers) {
+        if (layer.name == name) return layer;
+    }
+    throw std::out_of_range("Render layer not found: " + name);
+}
+
+
+void render_layer_invalidate(const std::string& name) {
+    Render_layer& layer = render_layer_get(name);
+    layer.baked = false;
+    baked_views.erase(layer.depth);
+
+    auto it = render_batches.find(layer.depth);
+    if (it == render_batches.end()) return;
+    it->second.first.vert_count = 0;
+    it->second.second.vert_count = 0;
+    it->second.second.index_count = 0;
+}
+
+
+void render_layer_remove(const std::string& name) {
+    for (auto it = render_layers.begin(); it != render_layers.end(); ++it) {
+        if (it->second.name != name) continue;
+        render_batches.erase(it->first);     // Cached static content and sort state go with it
+        baked_views.erase(it->first);
+        render_layers.erase(it);
+        return;
+    }
+}
+
+
+// Makes sure the buffer can take 'count' more vertices
+static void reserve_vertices(VertexBuffer& buf, int count) {
+    size_t needed = buf.vert_count + count;
+    if (buf.vertices.size() < needed) {
+        buf.vertices.resize(SDL_max(needed, buf.vertices.size() * 2));
+        buf.pages.resize(buf.vertices.size() / 4);
+    }
+}
+
+
+// Shared index pattern for textured batches, every quad is {0, 1, 2, 2, 3, 0}
+static const int* quad_indices(int quad_count) {
+    size_t old_quads = quad_index_pattern.size() / 6;
+    if (old_quads < (size_t)quad_count) {
+        quad_index_pattern.resize(quad_count * 6);
+        for (size_t q = old_quads; q < (size_t)quad_count; q++) {
+            int  v = q * 4;
+            int* i = &quad_index_pattern[q * 6];
+            i[0] = v + 0; i[1] = v + 1; i[2] = v + 2;
+            i[3] = v + 2; i[4] = v + 3; i[5] = v + 0;
+        }
+    }
+    return quad_index_pattern.data();
+}
+
+
+// Textured quad path, 'key' and 'tag' are only stored for y-sorted layers
+static void submit_quad(Uint16 depth, const SDL_Vertex vertices[4], float key, Uint32 tag, Uint8 page) {
+    Render_layer* layer = layer_at(depth);
+    if (layer != nullptr && layer->baked) return;
+
+    VertexBuffer& tex = render_batches[depth].first;
+    reserve_vertices(tex, 4);
+
+    int& c = tex.vert_count;
+    tex.pages[c / 4] = page;
+    tex.vertices[c++] = vertices[0];
+    tex.vertices[c++] = vertices[1];
+    tex.vertices[c++] = vertices[2];
+    tex.vertices[c++] = vertices[3];
+
+    if (layer != nullptr && layer->y_sort) {
+        int q = c / 4 - 1;
+        if (tex.sort_keys.size() <= (size_t)q) {
+            tex.sort_keys.resize(tex.vertices.size() / 4);
+            tex.sort_tags.resize(tex.vertices.size() / 4);
+        }
+        tex.sort_keys[q] = key;
+        tex.sort_tags[q] = tag;
+        tex.order_dirty = true;
+    }
+}
+
+
+void render_submit_vertices(const SDL_Vertex vertices[], const int* indices, int index_count, int vert_count, Uint16 depth, bool is_primitive, Uint8 page) {
+    if (is_baked(depth)) return;
     std::pair<VertexBuffer, VertexBuffer>& buf = render_batches[depth];
 
     if (is_primitive) 
     {
-        Uint16& cc   = buf.second.vert_count;
-        Uint16& ii   = buf.second.index_count;
+        VertexBuffer& prim = buf.second;
+        reserve_vertices(prim, vert_count);
+        if (prim.indices.size() < (size_t)(prim.index_count + index_count)) {
+            prim.indices.resize(SDL_max((size_t)(prim.index_count + index_count), prim.indices.size() * 2));
+        }
+
+        int& cc   = prim.vert_count;
+        int& ii   = prim.index_count;
         // For each indices
-        for (int i = 0; i < indices.size(); i++) {
-            buf.second.indices[ii++] = cc + indices[i];
+        for (int i = 0; i < index_count; i++) {
+            prim.indices[ii++] = cc + indices[i];
         }
 
         // For each vertex
         for (int i = 0; i < vert_count; i++) {
-            buf.second.vertices[cc++] = vertices[i];
+            prim.vertices[cc++] = vertices[i];
         }
     }
     else 
     {
         // literally just a quad, hopefully lol (no test cases aahhh type shit...)
-        Uint16& c   = buf.first.vert_count;
-        Uint16& i   = buf.first.index_count;
+        float bottom = SDL_max(SDL_max(vertices[0].position.y, vertices[1].position.y),
+                               SDL_max(vertices[2].position.y, vertices[3].position.y));
+        submit_quad(depth, vertices, bottom, ANONYMOUS_TAG | (buf.first.vert_count / 4), page);
+    }
+}
 
-        buf.first.indices[i++] = c + 0;
-        buf.first.indices[i++] = c + 1;
-        buf.first.indices[i++] = c + 2;
-        buf.first.indices[i++] = c + 2;
-        buf.first.indices[i++] = c + 3;
-        buf.first.indices[i++] = c + 0;
 
-        buf.first.vertices[c++] = vertices[0];
-        buf.first.vertices[c++] = vertices[1];
-        buf.first.vertices[c++] = vertices[2];
-        buf.first.vertices[c++] = vertices[3];
+SDL_Vertex* render_batch_quads_begin(Uint16 depth, int max_quads, Uint8 page) {
+    if (is_baked(depth)) {
+        if (discard.size() < (size_t)max_quads * 4) discard.resize(max_quads * 4);
+        return discard.data();
     }
-
-    rendered_c++;
+    VertexBuffer& tex = render_batches[depth].first;
+    reserve_vertices(tex, max_quads * 4);
+    tex.pending_page = page;
+    return tex.vertices.data() + tex.vert_count;
 }
 
 
-void render_batch_entity(const Entity& entity, const Camera& cam) {
-    // Render if at least one vertex is seenable
-    Polygon<4> ent_shape(entity.transformed_vertices);
-    if (!camera_is_polygon_in(cam, ent_shape)) return;
+void render_batch_quads_end(Uint16 depth, int quad_count) {
+    Render_layer* layer = layer_at(depth);
+    if (layer != nullptr && layer->baked) return;
 
-    SDL_Vertex vertices[4];
-    Vector2f tl = world_to_screen(cam, ent_shape[0]);
-    Vector2f tr = world_to_screen(cam, ent_shape[1]);
-    Vector2f br = world_to_screen(cam, ent_shape[2]);
-    Vector2f bl = world_to_screen(cam, ent_shape[3]);
-    Vector4f uv = sprite_frame_at_uv(entity.sprite.sprite_id, entity.image_index);
+    VertexBuffer& tex = render_batches[depth].first;
+    int first = tex.vert_count / 4;
+    tex.vert_count += quad_count * 4;
+    std::fill_n(tex.pages.begin() + first, quad_count, tex.pending_page);
+    if (layer == nullptr || !layer->y_sort) return;
+
+    // Bulk quads have no identity, they sort by their bottom edge
+    tex.sort_keys.resize(SDL_max(tex.sort_keys.size(), (size_t)(first + quad_count)));
+    tex.sort_tags.resize(tex.sort_keys.size());
+    for (int q = first; q < first + quad_count; q++) {
+        const SDL_Vertex* v = &tex.vertices[q * 4];
+        tex.sort_keys[q] = SDL_max(SDL_max(v[0].position.y, v[1].position.y), SDL_max(v[2].position.y, v[3].position.y));
+        tex.sort_tags[q] = ANONYMOUS_TAG | q;
+    }
+    tex.order_dirty = true;
+}
 
+
+// Batches hold world coordinates, the camera is applied in render_batch_all
+static void write_quad(SDL_Vertex out[4], const std::array<Vector2f, 4>& corners, const Vector4f& uv, SDL_FColor color) {
     // Top left
-    vertices[0].position.x = tl.x();
-    vertices[0].position.y = tl.y();
-    vertices[0].tex_coord.x = uv.x();
-    vertices[0].tex_coord.y = uv.y();
-    vertices[0].color = entity.c_blend; 
+    out[0].position.x = corners[0].x();
+    out[0].position.y = corners[0].y();
+    out[0].tex_coord.x = uv.x();
+    out[0].tex_coord.y = uv.y();
+    out[0].color = color; 
 
     // Top Right
-    vertices[1].position.x = tr.x();
-    vertices[1].position.y = tr.y();
-    vertices[1].tex_coord.x = uv.z();
-    vertices[1].tex_coord.y = uv.y();
-    vertices[1].color = entity.c_blend;
+    out[1].position.x = corners[1].x();
+    out[1].position.y = corners[1].y();
+    out[1].tex_coord.x = uv.z();
+    out[1].tex_coord.y = uv.y();
+    out[1].color = color;
 
     // Bottom right
-    vertices[2].position.x = br.x();
-    vertices[2].position.y = br.y();
-    vertices[2].tex_coord.x = uv.z();
-    vertices[2].tex_coord.y = uv.w();
-    vertices[2].color = entity.c_blend;
+    out[2].position.x = corners[2].x();
+    out[2].position.y = corners[2].y();
+    out[2].tex_coord.x = uv.z();
+    out[2].tex_coord.y = uv.w();
+    out[2].color = color;
     
     // Bottom left
-    vertices[3].position.x = bl.x();
-    vertices[3].position.y = bl.y();
-    vertices[3].tex_coord.x = uv.x();
-    vertices[3].tex_coord.y = uv.w();
-    vertices[3].color = entity.c_blend;
+    out[3].position.x = corners[3].x();
+    out[3].position.y = corners[3].y();
+    out[3].tex_coord.x = uv.x();
+    out[3].tex_coord.y = uv.w();
+    out[3].color = color;
+}
+
 
-    std::vector<int> indices;
-    render_submit_vertices(vertices, indices, 4, entity.depth, false);
+void render_batch_entity(const Entity& entity) {
+    SDL_Vertex vertices[4];
+    // update_frame keeps image_index inside the sheet, so the table is indexed as is
+    write_quad(vertices, entity.transformed_vertices, entity.sprite->uvs[entity.image_index], entity.c_blend);
+
+    // Entities sort by where they stand, ties keep their spawn order
+    submit_quad(entity.depth, vertices, entity.position.y(), entity.id, entity.sprite->page);
 }
 
 
 void render_batch_sprite(const Uint64 sprite_id, Uint8 index, float rotation, Vector2f scale, 
-    Uint16 depth, const std::array<Vector2f, 4>& vertices, const Camera& cam) {
-    // Render if at least one vertex is seenable
-    Polygon<4> ent_shape(vertices);
-    if (!camera_is_polygon_in(cam, ent_shape)) return;
+    Uint16 depth, const std::array<Vector2f, 4>& vertices) {
 
     SDL_Vertex vertices_sdl[4];
-    Vector2f tl = world_to_screen(cam, ent_shape[0]);
-    Vector2f tr = world_to_screen(cam, ent_shape[1]);
-    Vector2f br = world_to_screen(cam, ent_shape[2]);
-    Vector2f bl = world_to_screen(cam, ent_shape[3]);
     Vector4f uv = sprite_frame_at_uv(sprite_id, index);
 
     // TODO: apply transformation matrix here (rotation and Scale)
+    write_quad(vertices_sdl, vertices, uv, {1, 1, 1, 1});
 
-    // Top left
-    vertices_sdl[0].position.x = tl.x();
-    vertices_sdl[0].position.y = tl.y();
-    vertices_sdl[0].tex_coord.x = uv.x();
-    vertices_sdl[0].tex_coord.y = uv.y();
-    vertices_sdl[0].color = {1, 1, 1, 1}; 
+    render_submit_vertices(vertices_sdl, nullptr, 0, 4, depth, false, sprite_get(sprite_id).page);
+}
 
-    // Top Right
-    vertices_sdl[1].position.x = tr.x();
-    vertices_sdl[1].position.y = tr.y();
-    vertices_sdl[1].tex_coord.x = uv.z();
-    vertices_sdl[1].tex_coord.y = uv.y();
-    vertices_sdl[1].color = {1, 1, 1, 1};
 
-    // Bottom right
-    vertices_sdl[2].position.x = br.x();
-    vertices_sdl[2].position.y = br.y();
-    vertices_sdl[2].tex_coord.x = uv.z();
-    vertices_sdl[2].tex_coord.y = uv.w();
-    vertices_sdl[2].color = {1, 1, 1, 1};
-    
-    // Bottom left
-    vertices_sdl[3].position.x = bl.x();
-    vertices_sdl[3].position.y = bl.y();
-    vertices_sdl[3].tex_coord.x = uv.x();
-    vertices_sdl[3].tex_coord.y = uv.w();
-    vertices_sdl[3].color = {1, 1, 1, 1};
+/**
+ * Brings last frame's draw order up to date with this frame's quads and re-sorts it.
+ * The order is remembered by sort tag (entity id), not by quad slot, since culling and
+ * swap-removed entities shift the slots every frame. Mapped back to this frame's slots
+ * it is nearly sorted already and insertion sort repairs it in ~O(N). Should the keys
+ * have moved a lot anyway, the shift budget runs out and std::sort takes over.
+ */
+static void repair_order(VertexBuffer& buf) {
+    std::vector<int>& order = buf.order;
+    int quad_count = buf.vert_count / 4;
+    const float*  keys = buf.sort_keys.data();
+    const Uint32* tags = buf.sort_tags.data();
+
+    // Slot of every entity tag this frame, anonymous quads are identified by their slot
+    for (int q = 0; q < quad_count; q++) {
+        if (tags[q] & ANONYMOUS_TAG) continue;
+        if (buf.tag_slots.size() <= tags[q]) buf.tag_slots.resize(tags[q] + 1, -1);
+        buf.tag_slots[tags[q]] = q;
+    }
+
+    // Last frame's order first, then the quads that weren't drawn last frame
+    Uint8* placed = (Uint8*)frame_alloc(SDL_max(quad_count, 1), 1);
+    SDL_memset(placed, 0, quad_count);
+    order.clear();
+    for (Uint32 tag : buf.order_tags) {
+        int slot = (tag & ANONYMOUS_TAG) ? (int)(tag & ~ANONYMOUS_TAG) : (tag < buf.tag_slots.size() ? buf.tag_slots[tag] : -1);
+        if (slot < 0 || slot >= quad_count || tags[slot] != tag || placed[slot]) continue;
+        placed[slot] = 1;
+        order.push_back(slot);
+    }
+    for (int q = 0; q < quad_count; q++) {
+        if (!placed[q]) order.push_back(q);
+    }
+
+    auto before = [keys, tags](int a, int b) {
+        return keys[a] < keys[b] || (keys[a] == keys[b] && tags[a] < tags[b]);
+    };
+    Sint64 budget = (Sint64)quad_count * 8;
+    for (int i = 1; i < quad_count && budget >= 0; i++) {
+        int slot = order[i];
+        int j = i - 1;
+        while (j >= 0 && before(slot, order[j])) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = slot;
+        budget -= i - 1 - j;
+    }
+    if (budget < 0) std::sort(order.begin(), order.end(), before);
 
-    std::vector<int> indices;
-    render_submit_vertices(vertices_sdl, indices, 4, depth, false);
+    buf.order_tags.resize(quad_count);
+    for (int i = 0; i < quad_count; i++) {
+        buf.order_tags[i] = tags[order[i]];
+    }
+    for (int q = 0; q < quad_count; q++) {
+        if (!(tags[q] & ANONYMOUS_TAG)) buf.tag_slots[tags[q]] = -1;
+    }
+    buf.order_dirty = false;
 }
 
 
-// Draws all sprite loaded from the batch with all Depth value
-void render_batch_all(bool debug) {
+/**
+ * Batch transform stage, applies the camera's view matrix to every quad of a
+ * textured batch and keeps only the quads overlapping the viewport.
+ * Culling happens in screen space, so it is exact for rotated views.
+ * Quads are visited in 'order' when given, in submission order otherwise.
+ * Returns the amount of visible quads written into 'out', their pages go to 'out_pages'.
+ */
+static int transform_quads(const VertexBuffer& buf, const int* order, const Affine2f& view, const Vector4f& bounds,
+    SDL_Vertex* out, Uint8* out_pages) {
+    const float a = view(0, 0), b = view(0, 1), tx = view(0, 2);
+    const float c = view(1, 0), d = view(1, 1), ty = view(1, 2);
+    int quad_count = buf.vert_count / 4;
+    int visible = 0;
+
+    for (int q = 0; q < quad_count; q++) {
+        int slot = order ? order[q] : q;
+        const SDL_Vertex* in = &buf.vertices[slot * 4];
+        float lo_x = FLT_MAX, lo_y = FLT_MAX;
+        float hi_x = -FLT_MAX, hi_y = -FLT_MAX;
+
+        for (int k = 0; k < 4; k++) {
+            float x = a * in[k].position.x + b * in[k].position.y + tx;
+            float y = c * in[k].position.x + d * in[k].position.y + ty;
+            out[k].position = {x, y};
+            out[k].color = in[k].color;
+            out[k].tex_coord = in[k].tex_coord;
+
+            lo_x = SDL_min(lo_x, x);  hi_x = SDL_max(hi_x, x);
+            lo_y = SDL_min(lo_y, y);  hi_y = SDL_max(hi_y, y);
+        }
 
-    // For each Sprite_id request
-    for (auto& [depth, batch] : render_batches) {
+        if (hi_x < bounds.x() || lo_x > bounds.z() || hi_y < bounds.y() || lo_y > bounds.w()) continue;
+        out += 4;
+        out_pages[visible++] = buf.pages[slot];
+    }
+    return visible;
+}
 
-        // Render using the texture corresponding to this depth batch
-        SDL_RenderGeometry(         // Textured
+
+// Picks the copy made with this zoom and rotation, or rebuilds the least recently used one
+static Baked_view& baked_view(const Render_layer& layer, VertexBuffer& quads, const VertexBuffer& prims, const Affine2f& view) {
+    std::array<Baked_view, 2>& views = baked_views[layer.depth];
+    Baked_view* slot = &views[0];
+    for (Baked_view& v : views) {
+        if (v.linear == view.linear()) { slot = &v; break; }
+        if (v.last_used < slot->last_used) slot = &v;
+    }
+    slot->last_used = draw_pass;
+    if (slot->linear == view.linear()) return *slot;
+
+    if (layer.y_sort && quads.order_dirty) repair_order(quads);
+    slot->linear = view.linear();
+    slot->offset = {NAN, NAN};
+    slot->quad_verts = quads.vert_count;
+    slot->base.resize(quads.vert_count + prims.vert_count);
+    slot->vertices.resize(slot->base.size());
+    slot->pages.resize(quads.vert_count / 4);
+
+    for (int q = 0; q < quads.vert_count / 4; q++) {
+        int src = layer.y_sort ? quads.order[q] : q;
+        for (int k = 0; k < 4; k++) slot->base[q * 4 + k] = quads.vertices[src * 4 + k];
+        slot->pages[q] = quads.pages[src];
+    }
+    for (int i = 0; i < prims.vert_count; i++) slot->base[quads.vert_count + i] = prims.vertices[i];
+
+    for (SDL_Vertex& v : slot->base) {
+        Vector2f p = slot->linear * Vector2f(v.position.x, v.position.y);
+        v.position = {p.x(), p.y()};
+    }
+    return *slot;
+}
+
+
+// One draw call per run of quads sharing an atlas page
+static void draw_quad_runs(const SDL_Vertex* vertices, const Uint8* pages, int quad_count, int mip) {
+    const int* indices = quad_indices(quad_count);
+    for (int start = 0; start < quad_count;) {
+        Uint8 page = pages[start];
+        int end = start + 1;
+        while (end < quad_count && pages[end] == page) end++;
+
+        SDL_RenderGeometry(     // Textured
             renderer, 
-            sprite_get_atlas(), 
-            batch.first.vertices, 
-            batch.first.vert_count, 
-            batch.first.indices, 
-            batch.first.index_count
+            sprite_get_atlas(page, mip), 
+            vertices + start * 4, 
+            (end - start) * 4, 
+            indices, 
+            (end - start) * 6
         );
+        start = end;
+    }
+}
 
-        SDL_RenderGeometry(         // Primitives
+
+// Baked layers only move by the camera's translation: no per quad transform or cull, the copy is shifted when it changed
+static void draw_baked(Baked_view& baked, const Vector2f& offset, const VertexBuffer& prims, int mip) {
+    if (baked.offset != offset) {
+        baked.offset = offset;
+        for (size_t i = 0; i < baked.base.size(); i++) {
+            baked.vertices[i] = baked.base[i];
+            baked.vertices[i].position.x += offset.x();
+            baked.vertices[i].position.y += offset.y();
+        }
+    }
+
+    int quad_count = baked.quad_verts / 4;
+    rendered_c += quad_count;
+    draw_quad_runs(baked.vertices.data(), baked.pages.data(), quad_count, mip);
+
+    if (prims.index_count > 0) {
+        SDL_RenderGeometry(     // Primitives
             renderer, 
             sprite_get_atlas(), 
-            batch.second.vertices, 
-            batch.second.vert_count, 
-            batch.second.indices, 
-            batch.second.index_count
+            baked.vertices.data() + baked.quad_verts, 
+            (int)baked.vertices.size() - baked.quad_verts, 
+            prims.indices.data(), 
+            prims.index_count
         );
     }
 }
 
+
+// Draws all sprite loaded from the batch with all Depth value
+void render_batch_all(const Camera& cam, bool debug) {
+    draw_pass++;
+    Affine2f cam_view = cam.view();
+    float margin = cam_culling_margin() * cam.zoom;
+    int mip = sprite_atlas_mip(cam.zoom);       // Downscaled pages when zoomed out, same UVs
+    Vector4f bounds = {-margin, -margin, cam.size.x() + margin, cam.size.y() + margin};
+
+    SDL_Rect viewport = {
+        (int)cam.viewport_pos.x(), (int)cam.viewport_pos.y(),
+        (int)cam.size.x(), (int)cam.size.y()
+    };
+    SDL_SetRenderViewport(renderer, &viewport);
+
+    // For each Sprite_id request
+    for (auto& [depth, batch] : render_batches) {
+        Affine2f view = cam_view;
+        const int* order = nullptr;
+
+        // Layers look through a camera whose position is scaled by the scroll factor
+        if (Render_layer* layer = layer_at(depth)) {
+            Camera layer_cam = cam;
+            layer_cam.position = cam.center().cwiseProduct(layer->scroll) - cam.size / 2;
+            view = layer_cam.view();
+
+            if (layer->baked) {
+                Vector4f view_box = layer_cam.bbox();
+                float m = cam_culling_margin();
+                if (layer->bounds.z() < view_box.x() - m || layer->bounds.x() > view_box.z() + m ||
+                    layer->bounds.w() < view_box.y() - m || layer->bounds.y() > view_box.w() + m) continue;
+
+                draw_baked(baked_view(*layer, batch.first, batch.second, view), view.translation(), batch.second, mip);
+                continue;
+            }
+
+            if (layer->y_sort) {
+                if (batch.first.order_dirty) repair_order(batch.first);
+                order = batch.first.order.data();
+            }
+        }
+
+        // Render using the texture corresponding to this depth batch
+        // Camera-transformed copies live in the frame arena, one per batch and camera
+        if (batch.first.vert_count > 0) {
+            SDL_Vertex* scratch = (SDL_Vertex*)frame_alloc(sizeof(SDL_Vertex) * batch.first.vert_count, alignof(SDL_Vertex));
+            Uint8* scratch_pages = (Uint8*)frame_alloc(batch.first.vert_count / 4, 1);
+            int visible = transform_quads(batch.first, order, view, bounds, scratch, scratch_pages);
+            rendered_c += visible;
+            draw_quad_runs(scratch, scratch_pages, visible, mip);    // Usually a single run
+        }
+
+        if (batch.second.vert_count > 0) {
+            SDL_Vertex* scratch = (SDL_Vertex*)frame_alloc(sizeof(SDL_Vertex) * batch.second.vert_count, alignof(SDL_Vertex));
+            for (int i = 0; i < batch.second.vert_count; i++) {
+                const SDL_Vertex& in = batch.second.vertices[i];
+                Vector2f p = view * Vector2f(in.position.x, in.position.y);
+                scratch[i] = in;
+                scratch[i].position = {p.x(), p.y()};
+            }
+
+            SDL_RenderGeometry(         // Primitives
+                renderer, 
+                sprite_get_atlas(), 
+                scratch, 
+                batch.second.vert_count, 
+                batch.second.indices.data(), 
+                batch.second.index_count
+            );
+        }
+    }
+
+    SDL_SetRenderViewport(renderer, NULL);
+}
+
 void set_color(const SDL_Color& color) {
     SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 }
@@ -190,8 +562,23 @@ void set_color(const SDL_FColor& color) {
     SDL_SetRenderDrawColorFloat(renderer, color.r, color.g, color.b, color.a);
 }
 
+// Keeps every depth and its storage alive, only the counts are reset.
+// Static layers get baked here, after their first frame of content was drawn.
 void render_batch_clear_all() {
-    render_batches.clear();
+    for (auto& [depth, batch] : render_batches) {
+        Render_layer* layer = layer_at(depth);
+        if (layer != nullptr && layer->is_static) {
+            if (!layer->baked && (batch.first.vert_count > 0 || batch.second.vert_count > 0)) {
+                bake_layer(*layer, batch);
+            }
+            if (layer->baked) continue;
+        }
+
+        batch.first.vert_count = 0;
+        batch.first.index_count = 0;
+        batch.second.vert_count = 0;
+        batch.second.index_count = 0;
+    }
     prev_rend_c = rendered_c;
     rendered_c = 0;
 }
@@ -4,26 +4,102 @@
 #include "../utils/util.hpp"
 #include "geometry.hpp"
 #include <vector>
+#include <string>
 #include <SDL3/SDL.h>
 #include <Eigen/Dense>
 using namespace Eigen;
 
-#define MAX_VERTEX_COUNT UINT16_MAX
 struct Entity;
 struct Camera;
 
+/**
+ * @brief A named depth with its own camera behaviour (parallax backdrops, UI...).
+ * 
+ * Depths without a layer scroll 1:1 with the camera and are rebuilt every frame.
+ * Options other than the ones taken by render_layer_add are set through render_layer_get.
+ */
+struct Render_layer {
+    std::string name;               /**< The name used to look the layer up. */
+    Uint16 depth;                   /**< The depth batch this layer owns. */
+    Vector2f scroll = {1, 1};       /**< Camera scroll factor, 0 = fixed to the screen, < 1 = far away. */
+    bool is_static = false;         /**< Content is submitted once and kept as a cached vertex buffer. */
+    bool y_sort = false;            /**< Quads are drawn ordered by their y (top-down / isometric scenes). */
+    bool baked = false;             /**< Static content is cached, new submissions are ignored. */
+    Vector4f bounds;                /**< World bounds of the cached content (static layers only). */
+};
+
 /**
  * @brief Stores vertex and index data for rendering.
  *        This buffer represents a whole depth
+ * 
+ * Storage only grows, clearing a batch just resets the counts so the
+ * memory is reused on the next frame. Textured buffers only hold quads,
+ * their indices come from a shared quad index pattern instead.
  */
 struct VertexBuffer {
-    SDL_Vertex  vertices[MAX_VERTEX_COUNT];   /**< Array of vertices for rendering. */
-    int         indices[MAX_VERTEX_COUNT / 2 * 6]; /**< Indices for indexed drawing. */
-    Uint16      vert_count;                   /**< Number of vertices currently stored. */
-    Uint16      index_count;                  /**< Number of indices currently stored. */
+    std::vector<SDL_Vertex> vertices;   /**< Array of vertices for rendering. */
+    std::vector<int>        indices;    /**< Indices for indexed drawing (primitives only). */
+    int         vert_count = 0;         /**< Number of vertices currently stored. */
+    int         index_count = 0;        /**< Number of indices currently stored. */
+    std::vector<Uint8> pages;           /**< Per quad atlas page (textured only). */
+    Uint8       pending_page = 0;       /**< Page of the quads reserved by render_batch_quads_begin. */
+
+    // Y-sorted layers only
+    std::vector<float>  sort_keys;      /**< Per quad y value, quads are drawn from low to high. */
+    std::vector<Uint32> sort_tags;      /**< Per quad stable ID, breaks ties between equal keys. */
+    std::vector<int>    order;          /**< This frame's draw order (quad slots). */
+    std::vector<Uint32> order_tags;     /**< Last draw order by sort tag, stays valid when slots shift between frames. */
+    std::vector<int>    tag_slots;      /**< Scratch, entity tag -> quad slot of this frame (-1 otherwise). */
+    bool        order_dirty = true;     /**< Set when new quads arrived since the last repair. */
 };
 
 
+/**
+ * @brief Creates (or reconfigures) the render layer owning a depth.
+ * 
+ * Static layers keep whatever was submitted to their depth on the first frame,
+ * so their content is never rebuilt, only re-offset by the camera each frame.
+ * 
+ * @param name The name of the layer.
+ * @param depth The depth batch the layer owns.
+ * @param scroll Scroll factor applied to the camera position for this layer.
+ * @param is_static Whether the content is cached after the first frame.
+ */
+void render_layer_add(const std::string& name, Uint16 depth, Vector2f scroll, bool is_static);
+
+
+/**
+ * @brief Retrieves a render layer by name.
+ * @param name The name of the layer.
+ * @return Reference to the Render_layer.
+ */
+Render_layer& render_layer_get(const std::string& name);
+
+
+/**
+ * @brief Drops the cached content of a static layer, it is rebuilt from the next submissions.
+ * @param name The name of the layer.
+ */
+void render_layer_invalidate(const std::string& name);
+
+
+/**
+ * @brief Removes a render layer, its depth goes back to a plain 1:1 dynamic depth.
+ *        Cached static content is dropped with it. Unknown names are ignored.
+ * @param name The name of the layer.
+ */
+void render_layer_remove(const std::string& name);
+
+
+/**
+ * @brief Whether content at a depth is seen through the cameras as is (no layer, or a 1:1 dynamic one).
+ *        Only then can submissions be skipped for being outside the cameras' world bounds.
+ * @param depth The depth to check.
+ * @return False for parallax and static layers.
+ */
+bool render_depth_cullable(Uint16 depth);
+
+
 /**
  * @brief Initializes the renderer with the given SDL_Renderer.
  * 
@@ -35,16 +111,17 @@ void render_init(SDL_Renderer* rend);
 // ALl draw calls will submit their vertices, appropriately
 // is_primitive if false, tells this function that a quad is requested because it needs texture
 // meaning primitive draw calls can't support texutes... I know I am bad at this shit
-void render_submit_vertices(const SDL_Vertex vertices[], const std::vector<int>& indices, int vert_count, Uint16 depth, bool is_primitive); 
+// page is the atlas page the quad samples from
+// indices are only read for primitives, quads can pass nullptr (no per call index vector)
+void render_submit_vertices(const SDL_Vertex vertices[], const int* indices, int index_count, int vert_count, Uint16 depth, bool is_primitive, Uint8 page = 0); 
 
 
 /**
- * @brief Adds an Entity to the rendering batch.
+ * @brief Adds an Entity to the rendering batch (world coordinates).
  * 
  * @param entity Reference to the Entity to batch.
- * @param cam The camera used for rendering transformations.
  */
-void render_batch_entity(const Entity& entity, const Camera& cam);
+void render_batch_entity(const Entity& entity);
 
 
 /**
@@ -55,10 +132,34 @@ void render_batch_entity(const Entity& entity, const Camera& cam);
  * @param rotation Rotation in radians.
  * @param scale Scaling factor for the sprite.
  * @param depth Rendering depth (higher = closer to screen).
- * @param vertices Array of 4 vertices defining the sprite quad.
- * @param cam The camera used for rendering transformations.
+ * @param vertices Array of 4 vertices defining the sprite quad (world coordinates).
+ */
+void render_batch_sprite(const Uint64 sprite_id, Uint8 index, float rotation, Vector2f scale, Uint16 depth, const std::array<Vector2f, 4>& vertices);
+
+
+/**
+ * @brief Reserves space for textured quads inside a depth batch.
+ * 
+ * Lets bulk producers (particles, text) write their vertices straight into the
+ * batch instead of going through render_submit_vertices one quad at a time.
+ * Every quad is 4 vertices in world coordinates ordered TL, TR, BR, BL. Must be followed by
+ * render_batch_quads_end() before reserving on the same depth again.
+ * 
+ * @param depth Rendering depth.
+ * @param max_quads Upper bound of quads that will be written.
+ * @param page The atlas page every written quad samples from.
+ * @return Pointer to max_quads * 4 writable vertices.
+ */
+SDL_Vertex* render_batch_quads_begin(Uint16 depth, int max_quads, Uint8 page = 0);
+
+
+/**
+ * @brief Commits the quads written after render_batch_quads_begin().
+ * 
+ * @param depth Rendering depth, same as the one given to begin.
+ * @param quad_count How many quads were actually written (<= max_quads).
  */
-void render_batch_sprite(const Uint64 sprite_id, Uint8 index, float rotation, Vector2f scale, Uint16 depth, const std::array<Vector2f, 4>& vertices, const Camera& cam);
+void render_batch_quads_end(Uint16 depth, int quad_count);
 
 
 // =========== PRIMITIVE SHAPES =================== //
@@ -110,9 +211,15 @@ void set_color(const SDL_FColor& color);
 /**
  * @brief Draws all VertexBuffers loaded from the batch, ordered by depth.
  * 
+ * Batches are kept in world coordinates, so the same batches can be drawn by
+ * several cameras per frame (split screen, minimap). Each call culls and
+ * transforms the batches once with the camera's view matrix and draws them
+ * inside the camera's viewport.
+ * 
+ * @param cam The camera to draw the batches with.
  * @param debug If true, enables debug rendering (e.g., outlines, diagnostics).
  */
-void render_batch_all(bool debug);
+void render_batch_all(const Camera& cam, bool debug);
 
 
 /**
@@ -123,6 +230,7 @@ void render_batch_clear_all();
 
 /**
  * @brief Returns a reference to the count of rendered objects in the current frame.
+ *        Quads are counted after culling, once per camera that draws them.
  * 
  * @return Reference to the rendered count integer.
  */
@@ -0,0 +1,150 @@
+#include "scene.hpp"
+#include "sprite.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// A slot keeps its arena between scenes, so loading into it again reuses the same blocks
+struct Scene_slot {
+    Scene scene;
+    Arena arena;
+    bool used = false;
+};
+
+static Scene_slot slots[MAX_SCENES];
+static std::vector<int> stack;              // Slot indices, top at the back
+
+static int pending = -1;                    // Slot being preloaded
+static bool pending_replaces = false;       // scene_switch, the top scene goes away on activation
+static Uint64 pending_start = 0;
+static std::thread loader;
+static std::atomic<bool> loaded = false;
+
+
+static void bind_top() {
+    entity_bind_pool(stack.empty() ? nullptr : slots[stack.back()].scene.entities);
+}
+
+
+static void unload_slot(int slot) {
+    Scene_slot& s = slots[slot];
+    if (s.scene.unload) s.scene.unload(s.scene);
+    arena_reset(s.arena);
+    SDL_Log("> Scene unloaded. {%s}", s.scene.name.c_str());
+    s.scene = Scene{};
+    s.used = false;
+}
+
+
+static bool begin_preload(const Scene& scene, bool replaces) {
+    if (pending != -1) {
+        SDL_Log("A scene is still loading. {%s, %s}", slots[pending].scene.name.c_str(), scene.name.c_str());
+        return false;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < MAX_SCENES && slot == -1; i++) {
+        if (!slots[i].used) slot = i;
+    }
+    if (slot == -1) {
+        SDL_Log("Too many scenes, max is %d. {%s}", MAX_SCENES, scene.name.c_str());
+        return false;
+    }
+
+    // The pool is created here, from then on the arena belongs to the loader until activation
+    Scene_slot& s = slots[slot];
+    s.used = true;
+    s.scene = scene;
+    s.scene.arena = &s.arena;
+    s.scene.entities = entity_pool_create(s.arena);
+
+    pending = slot;
+    pending_replaces = replaces;
+    pending_start = SDL_GetTicksNS();
+    loaded = false;
+    loader = std::thread([&s]() {
+        entity_bind_pool(s.scene.entities);
+        if (s.scene.preload) s.scene.preload(s.scene);
+        loaded = true;
+    });
+    return true;
+}
+
+
+// Waits for the loader and for the sprites it queued, then swaps the scene in
+static void activate_pending() {
+    if (pending == -1 || !loaded || sprite_stream_pending() > 0) return;
+    loader.join();
+
+    int slot = pending;
+    pending = -1;
+    if (pending_replaces && !stack.empty()) {
+        unload_slot(stack.back());
+        stack.pop_back();
+    }
+    stack.push_back(slot);
+
+    Scene& scene = slots[slot].scene;
+    entity_pool_resolve(scene.entities);
+    bind_top();
+    if (scene.start) scene.start(scene);
+    SDL_Log("> Scene started. {%s, loaded in %.2f ms, %.1f KB}",
+        scene.name.c_str(), (SDL_GetTicksNS() - pending_start) / 1e6, arena_used(*scene.arena) / 1024.0);
+}
+
+
+bool scene_push(const Scene& scene) {
+    return begin_preload(scene, false);
+}
+
+
+bool scene_switch(const Scene& scene) {
+    return begin_preload(scene, true);
+}
+
+
+void scene_pop() {
+    if (stack.empty()) return;
+    unload_slot(stack.back());
+    stack.pop_back();
+    bind_top();
+}
+
+
+void scene_update(float dt) {
+    activate_pending();
+    Scene* scene = scene_current();
+    if (scene != nullptr && scene->update) scene->update(*scene, dt);
+}
+
+
+void scene_render() {
+    Scene* scene = scene_current();
+    if (scene != nullptr && scene->render) scene->render(*scene);
+}
+
+
+Scene* scene_current() {
+    return stack.empty() ? nullptr : &slots[stack.back()].scene;
+}
+
+
+bool scene_loading() {
+    return pending != -1;
+}
+
+
+void scene_cleanup() {
+    if (loader.joinable()) loader.join();
+    if (pending != -1) unload_slot(pending);
+    pending = -1;
+
+    while (!stack.empty()) {
+        unload_slot(stack.back());
+        stack.pop_back();
+    }
+    for (Scene_slot& s : slots) {
+        arena_release(s.arena);
+    }
+    bind_top();
+}
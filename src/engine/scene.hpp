@@ -0,0 +1,89 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include "entity.hpp"
+#include "../utils/arena.hpp"
+#include <SDL3/SDL.h>
+#include <string>
+
+#define MAX_SCENES 8
+
+/**
+ * @brief A game state (level, menu, pause screen...) and the memory it owns.
+ *
+ * Scenes are described by their callbacks and handed to scene_push / scene_switch,
+ * which preload them on a background thread while the current scene keeps running.
+ * Everything a scene allocates from its arena, entities included, is dropped at
+ * once when it is unloaded.
+ */
+struct Scene {
+    std::string name;                                   /**< Name used in logs and the debug UI. */
+    void (*preload)(Scene& scene) = nullptr;            /**< Background thread: queue sprites with sprite_load_async, allocate 'state' and spawn entities. Nothing touching the renderer. */
+    void (*start)(Scene& scene) = nullptr;              /**< Main thread, once the preload is done and its sprites are uploaded. */
+    void (*update)(Scene& scene, float dt) = nullptr;   /**< Main thread, every simulation tick while on top of the stack. */
+    void (*render)(Scene& scene) = nullptr;             /**< Main thread, every frame while on top of the stack. */
+    void (*unload)(Scene& scene) = nullptr;             /**< Main thread, right before the arena is reset. */
+
+    void* state = nullptr;              /**< The scene's own data, usually arena_new'd in preload. */
+    Arena* arena = nullptr;             /**< Set by the scene manager, rewound when the scene is unloaded. */
+    Entity_pool* entities = nullptr;    /**< Set by the scene manager, bound while the scene is on top. */
+};
+
+
+/**
+ * @brief Preloads a scene in the background, then pushes it above the current one.
+ *        The scene below is paused (no update nor render) until the new one is popped.
+ * @param scene The scene description, copied.
+ * @return False when another scene is still loading or every scene slot is used.
+ */
+bool scene_push(const Scene& scene);
+
+
+/**
+ * @brief Preloads a scene in the background, then replaces the top scene with it.
+ *        The current scene runs until the switch, so heavy levels load without a hitch.
+ * @param scene The scene description, copied.
+ * @return False when another scene is still loading or every scene slot is used.
+ */
+bool scene_switch(const Scene& scene);
+
+
+/**
+ * @brief Unloads the top scene, the one below resumes.
+ */
+void scene_pop();
+
+
+/**
+ * @brief Activates a finished preload, then updates the top scene. Call every simulation tick.
+ * @param dt The tick duration in seconds.
+ */
+void scene_update(float dt);
+
+
+/**
+ * @brief Renders the top scene. Call once per frame.
+ */
+void scene_render();
+
+
+/**
+ * @brief Returns the scene on top of the stack.
+ * @return Pointer to the scene, nullptr before the first one is active.
+ */
+Scene* scene_current();
+
+
+/**
+ * @brief Returns whether a scene is being preloaded.
+ * @return True until the pending scene becomes active.
+ */
+bool scene_loading();
+
+
+/**
+ * @brief Unloads every scene and frees their arenas.
+ */
+void scene_cleanup();
+
+#endif
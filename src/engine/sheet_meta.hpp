@@ -0,0 +1,25 @@
+#ifndef SHEET_META_HPP
+#define SHEET_META_HPP
+
+#define SHEET_META_EXT ".sheet"
+
+/**
+ * Manifest next to a sprite sheet (spr_<name>_<N>.png -> spr_<name>_<N>.sheet).
+ * Written by tools/sheetgen and meant to be edited by hand, sheets without one
+ * are a single row played at the fps they were added with.
+ *
+ * Plain text, one directive per line, '#' starts a comment. Every directive is optional:
+ *   frames <count>                         Frame count, overrides the one in the file name
+ *   frame_size <w> <h>                     Untrimmed frame size, sheet width / count by default
+ *   grid <columns> <rows>                  Frames stored row-major, one row by default
+ *   fps <fps>                              Duration of frames without their own, 1 to 1000
+ *   loop <forward|once|pingpong>           Playback at the last frame, forward by default
+ *   pivot <x> <y>                          Pivot of every frame, in untrimmed frame pixels
+ *   frame <index> [duration <ms>] [pivot <x> <y>]
+ *                                          Per frame override, durations from 1 to 65535 ms
+ *
+ * It is parsed once when the sheet is loaded, into the frame tables of
+ * Sprite_sheet_data (and from there into the sprite pack).
+ */
+
+#endif
@@ -1,36 +1,110 @@
 #include "sprite.hpp"
 #include "camera.hpp"
 #include "entity.hpp"
+#include "atlas.hpp"
+#include "sprite_pack.hpp"
+#include "sheet_meta.hpp"
 #include "../utils/util.hpp"
+#include "../utils/arena.hpp"
 #include <SDL3/SDL.h>
 #include <Eigen/Dense>
 #include <SDL3_image/SDL_image.h>
 #include <dirent.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cmath>
+#include <cstring>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include <string>
+#include <atomic>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 using namespace Eigen;
 
-#define Skyline Vector2i
 #define SPRITE_DIR "assets/sprites/"
-#define MAX_ATLAS_SIZE 4096
-#define ATLAS_PADDING 2
+#define SPRITE_STREAM_BUDGET 4      // Decoded sheets uploaded per sprite_stream_update call
+
+#define ATLAS_CACHE_DIR "assets/cache/"
+
+#define SPRITE_ID_TABLE_SIZE (MAX_SPRITES * 2)     // Power of two, at most half full
 
 static SDL_Renderer* rend;
-static std::vector<Skyline> skylines;
-static Uint16 farthest_x;                   // Refers to the final width for Surface_atlas
-static Uint16 farthest_y;                   // Refers to the final height for Surface_atlas
 
-// HashID, SpriteSheetData
-static std::unordered_map<Uint64, Sprite_sheet_data> sprite_sheet_map;
-static SDL_Surface* surface_atlas = nullptr; // Gets cleanup when texture_atlas is created
-static SDL_Texture* texture_atlas = nullptr;
+// Dense sprite registry, reserved to MAX_SPRITES up front so entities can keep pointers into it.
+// Unloaded slots keep a sprite_id of 0 and are reused by the next sprite.
+static std::vector<Sprite_sheet_data> sprites;
+static std::vector<Uint16> free_sprite_slots;
+static int live_sprites = 0;
+
+// HashID -> slot, open addressing with linear probing. An id of 0 marks an empty entry.
+struct Sprite_id_entry {
+    Uint64 id;
+    Uint16 slot;
+};
+static Sprite_id_entry sprite_ids[SPRITE_ID_TABLE_SIZE];
+
+// A frame already blitted into a page, identical frames point at it instead of being stored again
+struct Stored_frame {
+    Uint8 page;
+    Vector2i location;
+    Vector2i size;
+};
+static std::unordered_map<Uint64, std::vector<Stored_frame>> stored_frames;  // Pixel hash, frames with that hash
+static std::vector<Atlas_page> atlas_pages;  // Page surfaces get cleanup when their texture is created
+static Atlas_settings atlas_settings;
+static Atlas_stats atlas_stats = {};
+static Uint64 untrimmed_pixels = 0;         // Frame pixels before / after trimming, for the stats
+static Uint64 trimmed_pixels = 0;
+static bool atlas_dump = false;             // Write Texture_atlas_<page>.png when the atlas gets built
+static bool atlas_built = false;            // Set once startup packing is over, later sheets are streamed
+
+// Runtime loading, sheets are decoded on stream_worker and uploaded on the main thread
+struct Stream_request {
+    std::string file;
+    int fps;
+    SDL_Surface* surface;
+    bool reload;                            // Changed on disk, replaces the loaded sheet
+};
+static std::unordered_map<Uint64, std::vector<SDL_Rect>> streamed_rects;   // HashID, rects owned on its streaming page
+static std::thread stream_worker;
+static std::mutex stream_mutex;
+static std::condition_variable stream_cv;
+static std::deque<Stream_request> stream_queue;     // Waiting for decode
+static std::vector<Stream_request> stream_ready;     // Decoded, waiting for upload
+static int stream_decoding = 0;
+static bool stream_quit = false;
+static std::thread watch_thread;                    // Hot reload, watches SPRITE_DIR
+static std::atomic<bool> watch_quit = false;
+
+// Downscaled copies of the startup pages, built on mip_worker and uploaded by sprite_stream_update
+struct Mip_job {
+    int page;
+    SDL_Surface* source;                    // Full resolution pixels, freed by the worker
+    SDL_Surface* levels[ATLAS_MIP_LEVELS - 1];
+};
+static std::thread mip_worker;
+static std::vector<Mip_job> mip_ready;              // Guarded by stream_mutex
+static std::atomic<bool> mip_quit = false;
+static Mapped_file pack_file;                       // The loaded sprite pack, backs the mips and evicted pages
+static Uint32 sprite_revision = 0;                  // Hands out Sprite_sheet_data::revision
+static Uint64 residency_frame = 0;                  // Counts sprite_stream_update calls, pages remember the last one they were drawn in
 
 
 SDL_Surface* crop_surface(SDL_Surface* src, int w, int h) {
     SDL_Surface* cropped = SDL_CreateSurface(w, h, src->format);
 
+    // Plain copy, blending onto the empty surface would darken translucent pixels
     SDL_Rect src_rect = { 0, 0, w, h };
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
     SDL_BlitSurface(src, &src_rect, cropped, nullptr);
     return cropped;
 }
@@ -44,12 +118,7 @@ SDL_FRect sprite_frame_at(const Uint64 sprite_id, Uint16 index) {
         return SDL_FRect{0, 0, 0, 0};
     }
 
-    SDL_FRect rect;
-    rect.x = data.location.x() + data.frame_size.x() * index;
-    rect.y = data.location.y();
-    rect.w = data.frame_size.x();
-    rect.h = data.frame_size.y();
-    return rect;
+    return data.rects[index];
 }
 
 
@@ -60,159 +129,928 @@ Vector4f sprite_frame_at_uv(const Uint64 sprite_id, Uint16 index) {
         SDL_Log("Warning: Invalid frame index %d for sprite %s", index, data.sprite_name.c_str());
         return Vector4f{0, 0, 0, 0};
     }
+    return data.uvs[index];
+}
 
-    Vector4f s_uv = data.UV_coord;
-    float f_w = (s_uv.z() - s_uv.x()) / data.frame_count;
 
-    float u_start = s_uv.x() + index * f_w;
-    float u_end = u_start + f_w;
+// ===============================================
 
-    Vector4f uv;
-    uv.x() = u_start;
-    uv.y() = s_uv.y();
-    uv.z() = u_end;
-    uv.w() = s_uv.w();
-    return uv;
+
+// Slot of a sprite id, -1 when it isn't loaded. FNV-1a ids are well mixed, so the low bits index directly.
+static int find_sprite(Uint64 sprite_id) {
+    if (sprite_id == 0) return -1;
+    for (Uint32 i = sprite_id & (SPRITE_ID_TABLE_SIZE - 1);; i = (i + 1) & (SPRITE_ID_TABLE_SIZE - 1)) {
+        if (sprite_ids[i].id == sprite_id) return sprite_ids[i].slot;
+        if (sprite_ids[i].id == 0) return -1;
+    }
 }
 
 
-// ===============================================
+// False when the id is taken, by the same sprite or by another name hashing to the same id
+static bool sprite_id_free(Uint64 sprite_id, const std::string& sprite_name) {
+    int slot = find_sprite(sprite_id);
+    if (slot == -1) return true;
 
+    if (sprites[slot].sprite_name == sprite_name) SDL_Log("Sprite {%s} already exists.", sprite_name.c_str());
+    else SDL_Log("Sprite id collision, {%s} hashes like {%s}. Rename one of them.", sprite_name.c_str(), sprites[slot].sprite_name.c_str());
+    return false;
+}
 
-void reset() {
-    if (!surface_atlas) surface_atlas = SDL_CreateSurface(MAX_ATLAS_SIZE, MAX_ATLAS_SIZE, SDL_PIXELFORMAT_RGBA32);
-    if (texture_atlas) SDL_DestroyTexture(texture_atlas);
-    texture_atlas = nullptr; 
-    sprite_sheet_map.clear();
-    farthest_x = 0;
-    farthest_y = 0;
 
-    // Reset Skyline
-    skylines.clear();
-    skylines.push_back({0, 0}); // Flat ground
+// Moves a sprite into a free slot and indexes its id, nullptr when the registry is full
+static Sprite_sheet_data* register_sprite(Sprite_sheet_data&& data) {
+    Uint16 slot;
+    if (!free_sprite_slots.empty()) {
+        slot = free_sprite_slots.back();
+        free_sprite_slots.pop_back();
+    }
+    else if (sprites.size() < MAX_SPRITES) {
+        slot = sprites.size();
+        sprites.emplace_back();
+    }
+    else {
+        SDL_Log("Sprite registry full (%d sprites). {%s}", (int)MAX_SPRITES, data.sprite_name.c_str());
+        return nullptr;
+    }
+
+    Uint32 i = data.sprite_id & (SPRITE_ID_TABLE_SIZE - 1);
+    while (sprite_ids[i].id != 0) i = (i + 1) & (SPRITE_ID_TABLE_SIZE - 1);
+    sprite_ids[i] = {data.sprite_id, slot};
+    data.revision = ++sprite_revision;
+    sprites[slot] = std::move(data);
+    live_sprites++;
+    return &sprites[slot];
 }
 
-// A function for abstracting the adding process of a SpriteSheet to a texture atlas / SpriteSheet map
-bool pack_sprite_sheet(const Vector2i size, Vector2i& out) {
-    if (size.x() == 0 || size.y() == 0) 
-        return false;
-    
-    Uint16 skyline_count = skylines.size();
-    Uint16 max_w = MAX_ATLAS_SIZE;
-    Uint16 max_h = MAX_ATLAS_SIZE;
-    Uint16 w = size.x();
-    Uint16 h = size.y();
-
-    // Best candiate attributes
-    Uint16 best_idx     = UINT16_MAX;
-    Uint16 best_idx2    = UINT16_MAX;
-    Uint16 bestX        = UINT16_MAX;
-    Uint16 bestY        = UINT16_MAX;
-    
-    // For each skylines
-    for (int i = 0; i < skyline_count; i++) {
-        int x = skylines[i].x();
-        int y = skylines[i].y();
-
-        // If the current Skyline.x + requested Width Exceeds MAX_ATLAS_WIDTH, move on
-        if (x + w > max_w) break;
-        // We want the lowest Y possible
-        if (y >= bestY) continue;
-
-        // Raise Y to avoid overlaping skylines
-        Uint16 xMax = x + w; 
-        Uint16 i2;
-        
-        // Loop through all upcoming skylines relative to this current skyline point
-        for (i2 = i + 1; i2 < skyline_count; i2++) {        // stops at The index where the spriteSheet stops overlapping
-            if (xMax <= skylines[i2].x()) break;            // Check to see if Bottom Right and other ahead point is overlapping
-            if (y < skylines[i2].y()) y = skylines[i2].y(); // We are looking for the Peakest Overlapping Skyline
-        }
-
-        // Don't get higher than the bestY or Max height(Atlas)
-        if (y >= bestY || h > max_h)
-            continue;
 
-        best_idx = i;
-        best_idx2 = i2;
-        bestX = x;
-        bestY = y;
+// Frees the slot and removes the id with backward shift deletion, so probe chains stay unbroken
+static void unregister_sprite(Uint64 sprite_id) {
+    const Uint32 mask = SPRITE_ID_TABLE_SIZE - 1;
+    Uint32 i = sprite_id & mask;
+    while (sprite_ids[i].id != sprite_id) {
+        if (sprite_ids[i].id == 0) return;
+        i = (i + 1) & mask;
     }
 
-    // No Space to add
-    if (best_idx == UINT16_MAX) return false;
+    Uint16 slot = sprite_ids[i].slot;
+    sprites[slot] = Sprite_sheet_data{};
+    free_sprite_slots.push_back(slot);
+    live_sprites--;
+
+    for (Uint32 j = (i + 1) & mask; sprite_ids[j].id != 0; j = (j + 1) & mask) {
+        // An entry can fill the hole when the hole lies between its home and where it sits
+        Uint32 home = sprite_ids[j].id & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            sprite_ids[i] = sprite_ids[j];
+            i = j;
+        }
+    }
+    sprite_ids[i] = {0, 0};
+}
 
-    // Update Skyline silhouette
-    Vector2i TL, BR;
-    TL.x() = bestX;
-    TL.y() = bestY + h;
-    BR.x() = bestX + w;
-    BR.y() = skylines[best_idx2 - 1].y();
-    bool bBottomRight = (best_idx2 < skyline_count ? BR.x() < skylines[best_idx2].x() : BR.x() < max_w);
 
-    // Clean up overlapped skylines
-    if (best_idx2 > best_idx + 1)
-        skylines.erase(skylines.begin() + best_idx + 1, skylines.begin() + best_idx2);
-    
-    skylines[best_idx] = TL;
-    if (bBottomRight)
-        skylines.insert(skylines.begin() + best_idx + 1, BR);
+static void stop_mip_worker();
 
-    if (farthest_x < BR.x()) farthest_x = BR.x();
-    if (farthest_y < TL.y()) farthest_y = TL.y();
 
-    out.x() = bestX;
-    out.y() = bestY;
-    return true;
+void reset() {
+    stop_mip_worker();
+    for (Atlas_page& page : atlas_pages) {
+        atlas_page_destroy(page);
+    }
+    atlas_pages.clear();
+    unmap_file(pack_file);
+    sprites.clear();
+    sprites.reserve(MAX_SPRITES);
+    free_sprite_slots.clear();
+    live_sprites = 0;
+    std::fill(std::begin(sprite_ids), std::end(sprite_ids), Sprite_id_entry{0, 0});
+    stored_frames.clear();
+    streamed_rects.clear();
+    atlas_built = false;
+    atlas_stats = {};
+    untrimmed_pixels = 0;
+    trimmed_pixels = 0;
 }
 
 
-void update_texture_atlas() {
-    surface_atlas = crop_surface(surface_atlas, farthest_x, farthest_y);
-    texture_atlas = SDL_CreateTextureFromSurface(rend, surface_atlas);
+// Finds the stored copy of a frame on a page, nullptr if the page doesn't have it
+static const Stored_frame* find_stored(Uint64 hash, Uint8 page, SDL_Surface* sheet, const SDL_Rect& rect) {
+    auto it = stored_frames.find(hash);
+    if (it == stored_frames.end()) return nullptr;
 
-    // TL = { x / a_w            y / a_h };
-    // BR = { (x + w) / a_w      (y + h) / a_h  };
+    for (const Stored_frame& stored : it->second) {
+        if (stored.page != page || stored.size != Vector2i(rect.w, rect.h)) continue;
+        if (atlas_rect_equal(sheet, rect, atlas_pages[page].surface, stored.location)) return &stored;
+    }
+    return nullptr;
+}
 
-    for (auto& [key, value] : sprite_sheet_map) {
-        Vector4f& uv = value.UV_coord;
-        Vector2i& pos = value.location;
-        Vector2i size = value.sheet_size();
+
+/**
+ * Finds the first page that can hold a sheet's frames, opens a new page otherwise.
+ * Frames the page already stores are shared instead of packed, so the page is
+ * picked per sheet: every frame of a sheet lives on the same page.
+ * 'unique' marks the frames that need their own rect (not empty, not a repeat within the sheet),
+ * 'shared' gets the location of the stored copy of a frame, or {-1, -1}.
+ */
+static bool place_frames(SDL_Surface* sheet, const std::vector<SDL_Rect>& trimmed, const std::vector<Uint64>& hashes,
+    const std::vector<bool>& unique, Uint8& page, std::vector<Vector2i>& shared, std::vector<Vector2i>& packed) {
+
+    int pad = atlas_settings.padding;
+    std::vector<Vector2i> sizes;
+
+    for (size_t p = 0; p <= UINT8_MAX; p++) {
+        bool fresh = (p == atlas_pages.size());
+        if (fresh) {
+            atlas_pages.emplace_back();
+            atlas_page_init(atlas_pages.back(), atlas_settings.packer, atlas_settings.page_size, atlas_settings.page_size);
+        }
+
+        // Reserve the padding around the frame, the frame itself sits inside it
+        sizes.clear();
+        for (size_t f = 0; f < trimmed.size(); f++) {
+            const Stored_frame* stored = unique[f] ? find_stored(hashes[f], p, sheet, trimmed[f]) : nullptr;
+            shared[f] = stored ? stored->location : Vector2i(-1, -1);
+            if (unique[f] && stored == nullptr) sizes.push_back({trimmed[f].w + pad * 2, trimmed[f].h + pad * 2});
+        }
+
+        if (atlas_page_pack_all(atlas_pages[p], sizes, packed)) {
+            page = p;
+            return true;
+        }
+        if (fresh) {                // Doesn't even fit an empty page
+            atlas_page_destroy(atlas_pages.back());
+            atlas_pages.pop_back();
+            return false;
+        }
+    }
+    return false;
+}
+
+
+// TL = { x / a_w            y / a_h };
+// BR = { (x + w) / a_w      (y + h) / a_h  };
+// Rebuilds the UV and rect tables, the renderer reads them without touching the frames
+static void update_sprite_uv(Sprite_sheet_data& data) {
+    Vector2i a = atlas_pages[data.page].size;
+    data.uvs.resize(data.frames.size());
+    data.rects.resize(data.frames.size());
+
+    for (size_t f = 0; f < data.frames.size(); f++) {
+        Vector4f& uv = data.uvs[f];
+        const Vector2i& pos = data.frames[f].location;
+        const Vector2i& size = data.frames[f].size;
+        data.rects[f] = {(float)pos.x(), (float)pos.y(), (float)size.x(), (float)size.y()};
 
         // Min UV
-        uv.x() = (float)(pos.x() / (float)farthest_x);
-        uv.y() = (float)(pos.y() / (float)farthest_y);
+        uv.x() = (float)(pos.x() / (float)a.x());
+        uv.y() = (float)(pos.y() / (float)a.y());
 
         // Max UV
-        uv.z() = (float)(pos.x() + size.x()) / (float)farthest_x;
-        uv.w() = (float)(pos.y() + size.y()) / (float)farthest_y;
+        uv.z() = (float)(pos.x() + size.x()) / (float)a.x();
+        uv.w() = (float)(pos.y() + size.y()) / (float)a.y();
     }
+}
+
 
-    IMG_SavePNG(surface_atlas, "Texture_atlas.png");
-    SDL_DestroySurface(surface_atlas);
+// Unrolls one animation cycle into steps with their end times, so frames are a lookup of the elapsed time
+static void update_sprite_timeline(Sprite_sheet_data& data) {
+    data.timeline.clear();
+    data.step_ends.clear();
+    for (int f = 0; f < data.frame_count; f++) {
+        data.timeline.push_back(f);
+    }
+    if (data.loop == SPRITE_PINGPONG) {
+        for (int f = data.frame_count - 2; f > 0; f--) {
+            data.timeline.push_back(f);
+        }
+    }
+
+    // Every step lasts at least 1 ms, so the cycle length frame_at divides by is never 0
+    Uint32 end = 0;
+    data.step_ms = data.timeline.empty() ? 0 : SDL_max(data.frame_duration(data.timeline[0]), 1u);
+    for (Uint16 f : data.timeline) {
+        Uint32 duration = SDL_max(data.frame_duration(f), 1u);
+        if (duration != data.step_ms) data.step_ms = 0;
+        end += duration;
+        data.step_ends.push_back(end);
+    }
+    data.timeline_fps = data.fps;
+    data.timeline_loop = data.loop;
 }
 
 
-// Expects a Sprite_sheet
-// Sprite_id is the file_name
-// Adds this sprite_sheet to the Texture atlas
-//     example sprite_id: spr_player_5.png
-// Automatically assigns position for each individual sprite_sheet
-void sprite_add(const std::string sprite_file, int fps) {
-    std::string spr_name = extract_sprite_name(sprite_file);
-    Uint64 spr_id = hash_string(spr_name);
-    
-    // Check if sprite is already loaded
-    auto it = sprite_sheet_map.find(spr_id);
-    if (it != sprite_sheet_map.end()) {
-        SDL_Log("Sprite {%s} already exists.", sprite_file.c_str());
+static void update_uv() {
+    for (Sprite_sheet_data& spr : sprites) {
+        if (spr.sprite_id == 0) continue;
+        update_sprite_uv(spr);
+        update_sprite_timeline(spr);
+    }
+}
+
+
+// Only keeps the used part of the page_size working surfaces, UVs refer to the cropped size
+static void crop_pages() {
+    for (size_t i = 0; i < atlas_pages.size(); i++) {
+        Atlas_page& page = atlas_pages[i];
+        // Multiple of 4, so the half and quarter mips cover exactly the same UVs
+        Vector2i size = {SDL_min((page.used.x() + 3) & ~3, page.width), SDL_min((page.used.y() + 3) & ~3, page.height)};
+        SDL_Surface* cropped = crop_surface(page.surface, size.x(), size.y());
+        SDL_DestroySurface(page.surface);
+        page.surface = cropped;
+        page.size = size;
+
+        if (atlas_dump) {
+            std::string dump_file = "Texture_atlas_" + std::to_string(i) + ".png";
+            IMG_SavePNG(page.surface, dump_file.c_str());
+        }
+    }
+    update_uv();
+}
+
+
+void update_texture_atlas() {
+    for (Atlas_page& page : atlas_pages) {
+        page.texture = SDL_CreateTextureFromSurface(rend, page.surface);
+    }
+}
+
+
+static void upload_mips(Mip_job& job) {
+    Atlas_page& page = atlas_pages[job.page];
+    for (int l = 0; l < ATLAS_MIP_LEVELS - 1; l++) {
+        SDL_Surface* level = job.levels[l];
+        if (level != nullptr && !page.mips_stale && page.texture != nullptr) {     // Evicted pages rebuild theirs on restore
+            page.mips[l] = SDL_CreateTextureFromSurface(rend, level);
+            SDL_SetTextureBlendMode(page.mips[l], SDL_BLENDMODE_BLEND);
+        }
+        SDL_DestroySurface(level);
+    }
+}
+
+
+// Patched pixels would only show up at full resolution, zoomed out cameras fall back to it.
+// The pack no longer matches the page either, so it can't be evicted anymore.
+static void drop_page_mips(Atlas_page& page) {
+    page.mips_stale = true;
+    page.backing = nullptr;
+    for (SDL_Texture*& mip : page.mips) {
+        if (mip) SDL_DestroyTexture(mip);
+        mip = nullptr;
+    }
+}
+
+
+static Uint64 page_bytes(const Atlas_page& page) {
+    Uint64 bytes = page.texture ? (Uint64)page.size.x() * page.size.y() * 4 : 0;
+    for (int l = 0; l < ATLAS_MIP_LEVELS - 1; l++) {
+        if (page.mips[l]) bytes += (Uint64)(page.size.x() >> (l + 1)) * (page.size.y() >> (l + 1)) * 4;
+    }
+    return bytes;
+}
+
+
+// Uploads an evicted page again from the mapped pack, mips are rebuilt right away
+static void restore_page(Atlas_page& page) {
+    int w = page.size.x();
+    int h = page.size.y();
+    page.texture = SDL_CreateTexture(rend, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
+    SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(page.texture, nullptr, page.backing, page.backing_pitch);
+    atlas_stats.restores++;
+    if (!atlas_settings.mipmaps || page.mips_stale) return;
+
+    SDL_Surface* source = SDL_CreateSurfaceFrom(w, h, SDL_PIXELFORMAT_RGBA32, (void*)page.backing, page.backing_pitch);
+    SDL_Surface* from = source;
+    for (SDL_Texture*& mip : page.mips) {
+        SDL_Surface* level = from ? atlas_downscale(from) : nullptr;
+        if (level) {
+            mip = SDL_CreateTextureFromSurface(rend, level);
+            SDL_SetTextureBlendMode(mip, SDL_BLENDMODE_BLEND);
+        }
+        SDL_DestroySurface(from);
+        from = level;
+    }
+    SDL_DestroySurface(from);
+}
+
+
+static void evict_page(Atlas_page& page) {
+    SDL_DestroyTexture(page.texture);
+    page.texture = nullptr;
+    for (SDL_Texture*& mip : page.mips) {
+        if (mip) SDL_DestroyTexture(mip);
+        mip = nullptr;
+    }
+    atlas_stats.evictions++;
+}
+
+
+// Evicts the least recently drawn pages until the textures fit the budget, pages drawn last frame stay
+static void update_residency() {
+    Uint64 resident = 0;
+    for (const Atlas_page& page : atlas_pages) {
+        resident += page_bytes(page);
+    }
+
+    while (atlas_settings.texture_budget > 0 && resident > atlas_settings.texture_budget) {
+        Atlas_page* lru = nullptr;
+        for (Atlas_page& page : atlas_pages) {
+            if (page.texture == nullptr || page.backing == nullptr || page.last_used + 1 >= residency_frame) continue;
+            if (lru == nullptr || page.last_used < lru->last_used) lru = &page;
+        }
+        if (lru == nullptr) break;      // Everything left is in use or can't be restored
+
+        resident -= page_bytes(*lru);
+        evict_page(*lru);
+    }
+
+    atlas_stats.resident_bytes = resident;
+    atlas_stats.resident_pages = 0;
+    for (const Atlas_page& page : atlas_pages) {
+        if (page.texture) atlas_stats.resident_pages++;
+    }
+}
+
+
+static bool is_sprite_file(const std::string& name) {
+    return name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0;
+}
+
+
+// spr_<name>_<N>.png -> spr_<name>_<N>.sheet
+static std::string sheet_meta_file(const std::string& sprite_file) {
+    return sprite_file.substr(0, sprite_file.size() - 4) + SHEET_META_EXT;
+}
+
+
+// Sorted, so the atlas and the cache hash don't depend on readdir order
+static std::vector<std::string> list_sprite_files() {
+    std::vector<std::string> files;
+    DIR* dir = opendir(SPRITE_DIR);
+    if (dir == nullptr) {
+        SDL_Log("Directory not Found. {%s}", SPRITE_DIR);
+        return files;
+    }
+
+    for (dirent* entity = readdir(dir); entity != nullptr; entity = readdir(dir)) {
+        std::string file_name = std::string(entity->d_name);
+        if (file_name.find("spr_") != std::string::npos && is_sprite_file(file_name)) files.push_back(file_name);
+    }
+    closedir(dir);
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+
+static Uint64 hash_sprite_files(const std::vector<std::string>& files) {
+    Sint32 config[5] = {
+        SPRITE_PACK_VERSION, atlas_settings.packer, atlas_settings.sort,
+        atlas_settings.padding, atlas_settings.page_size
+    };
+    Uint64 hval = hash_bytes(config, sizeof(config));
+
+    for (const std::string& file : files) {
+        hval = hash_bytes(file.data(), file.size(), hval);
+
+        // The sidecar changes how the sheet is sliced, so it is part of the source too
+        for (const std::string& path : {file, sheet_meta_file(file)}) {
+            size_t size = 0;
+            void* data = SDL_LoadFile((std::string(SPRITE_DIR) + path).c_str(), &size);
+            if (data == nullptr) continue;
+            hval = hash_bytes(data, size, hval);
+            SDL_free(data);
+        }
+    }
+    return hval;
+}
+
+
+// Trimmed pixels inside the page and inside the untrimmed frame, empty frames are never read
+static bool valid_pack_frame(const Sprite_pack_frame& frame, const Sprite_pack_sprite& spr, const Sprite_pack_page& page) {
+    if (frame.w < 0 || frame.h < 0) return false;
+    if (frame.w == 0 || frame.h == 0) return true;
+    if (frame.x < 0 || frame.y < 0 || (Sint64)frame.x + frame.w > page.width || (Sint64)frame.y + frame.h > page.height) return false;
+    return frame.offset_x >= 0 && frame.offset_y >= 0 &&
+        (Sint64)frame.offset_x + frame.w <= spr.frame_w && (Sint64)frame.offset_y + frame.h <= spr.frame_h;
+}
+
+
+// Checks every table and blob of a mapped pack lies inside the file, and every frame inside its page
+static bool validate_pack(const Mapped_file& file) {
+    if (file.size < sizeof(Sprite_pack_header)) return false;
+    const Sprite_pack_header* header = (const Sprite_pack_header*)file.data;
+    if (header->magic != SPRITE_PACK_MAGIC || header->version != SPRITE_PACK_VERSION) return false;
+    if (header->page_count == 0 || header->page_count > UINT8_MAX) return false;
+
+    Uint64 tables = sizeof(Sprite_pack_header) +
+        (Uint64)header->page_count * sizeof(Sprite_pack_page) +
+        (Uint64)header->sprite_count * sizeof(Sprite_pack_sprite) +
+        (Uint64)header->frame_count * sizeof(Sprite_pack_frame) +
+        header->names_size;
+    if (tables > file.size) return false;
+
+    const Sprite_pack_page* pages = (const Sprite_pack_page*)(header + 1);
+    for (Uint32 i = 0; i < header->page_count; i++) {
+        const Sprite_pack_page& page = pages[i];
+        if (page.width == 0 || page.height == 0 || page.pitch < page.width * 4) return false;
+        if (page.pixel_offset < tables || page.pixel_offset + (Uint64)page.pitch * page.height > file.size) return false;
+    }
+
+    const Sprite_pack_sprite* sprites = (const Sprite_pack_sprite*)(pages + header->page_count);
+    const Sprite_pack_frame* frames = (const Sprite_pack_frame*)(sprites + header->sprite_count);
+    for (Uint32 i = 0; i < header->sprite_count; i++) {
+        const Sprite_pack_sprite& spr = sprites[i];
+        if (spr.frame_count <= 0 || spr.frame_count > UINT16_MAX || spr.page >= header->page_count) return false;
+        if (spr.frame_w <= 0 || spr.frame_h <= 0) return false;
+        if ((Uint64)spr.first_frame + spr.frame_count > header->frame_count) return false;
+        if ((Uint64)spr.name_offset + spr.name_length > header->names_size) return false;
+
+        for (Sint32 f = 0; f < spr.frame_count; f++) {
+            if (!valid_pack_frame(frames[spr.first_frame + f], spr, pages[spr.page])) return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * Loads a pack written by write_sprite_pack, false if it is missing, broken or stale.
+ * The pixels are handed from the mapping to SDL_UpdateTexture as they are. The file
+ * stays mapped (pack_file): page surfaces point into it until the mips are built,
+ * and pages evicted by the texture budget are uploaded from it again.
+ */
+static bool load_sprite_pack(const char* path, Uint64 source_hash, bool check_hash) {
+    Mapped_file& file = pack_file;
+    if (!map_file(path, file)) return false;
+
+    bool valid = validate_pack(file);
+    if (!valid) SDL_Log("Broken sprite pack, ignored. {%s}", path);
+    if (!valid || (check_hash && ((const Sprite_pack_header*)file.data)->source_hash != source_hash)) {
+        unmap_file(file);
+        return false;
+    }
+
+    const Sprite_pack_header* header = (const Sprite_pack_header*)file.data;
+    const Sprite_pack_page* pages = (const Sprite_pack_page*)(header + 1);
+    const Sprite_pack_sprite* sprites = (const Sprite_pack_sprite*)(pages + header->page_count);
+    const Sprite_pack_frame* frames = (const Sprite_pack_frame*)(sprites + header->sprite_count);
+    const char* names = (const char*)(frames + header->frame_count);
+
+    for (Uint32 i = 0; i < header->page_count; i++) {
+        const Sprite_pack_page& src = pages[i];
+        Atlas_page page;
+        page.size = page.used = {(int)src.width, (int)src.height};
+        page.texture = SDL_CreateTexture(rend, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, src.width, src.height);
+        SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+        SDL_UpdateTexture(page.texture, nullptr, file.data + src.pixel_offset, src.pitch);
+
+        // Read-only view of the mapping, the mip worker downscales straight from it
+        page.surface = SDL_CreateSurfaceFrom(src.width, src.height, SDL_PIXELFORMAT_RGBA32,
+            (void*)(file.data + src.pixel_offset), src.pitch);
+        page.backing = file.data + src.pixel_offset;
+        page.backing_pitch = src.pitch;
+        atlas_pages.push_back(page);
+    }
+
+    for (Uint32 i = 0; i < header->sprite_count; i++) {
+        const Sprite_pack_sprite& src = sprites[i];
+        Sprite_sheet_data spr = {};
+        spr.sprite_name.assign(names + src.name_offset, src.name_length);
+        spr.sprite_id = hash_string(spr.sprite_name);
+        if (!sprite_id_free(spr.sprite_id, spr.sprite_name)) continue;
+        spr.fps = src.fps;
+        spr.loop = (Sprite_loop)src.loop;
+        spr.frame_count = src.frame_count;
+        spr.page = src.page;
+        spr.frame_size = {src.frame_w, src.frame_h};
+
+        spr.frames.resize(spr.frame_count);
+        for (int f = 0; f < spr.frame_count; f++) {
+            const Sprite_pack_frame& frame = frames[src.first_frame + f];
+            spr.frames[f].location = {frame.x, frame.y};
+            spr.frames[f].offset = {frame.offset_x, frame.offset_y};
+            spr.frames[f].size = {frame.w, frame.h};
+            spr.frames[f].pivot = {frame.pivot_x, frame.pivot_y};
+            spr.frames[f].duration = frame.duration;
+        }
+        update_sprite_uv(spr);
+        update_sprite_timeline(spr);
+        register_sprite(std::move(spr));
+    }
+
+    atlas_stats.page_count = atlas_pages.size();
+    SDL_Log("  > Sprite pack loaded. {%s, %d sprites, %d pages}", path, (int)header->sprite_count, (int)header->page_count);
+    return true;
+}
+
+
+// Maps the pack just written from the built pages, so they can be evicted and restored like loaded ones
+static void map_pack_backing(const char* path) {
+    if (!map_file(path, pack_file)) return;
+    if (!validate_pack(pack_file)) {
+        unmap_file(pack_file);
         return;
     }
 
-    // Load Image file
-    SDL_Surface* sprite_sheet =  IMG_Load((std::string(SPRITE_DIR) + sprite_file).c_str());
-    if (!sprite_sheet) {
+    const Sprite_pack_header* header = (const Sprite_pack_header*)pack_file.data;
+    const Sprite_pack_page* pages = (const Sprite_pack_page*)(header + 1);
+    for (Uint32 i = 0; i < header->page_count && i < atlas_pages.size(); i++) {
+        Atlas_page& page = atlas_pages[i];
+        if ((int)pages[i].width != page.size.x() || (int)pages[i].height != page.size.y()) continue;
+        page.backing = pack_file.data + pages[i].pixel_offset;
+        page.backing_pitch = pages[i].pitch;
+    }
+}
+
+
+static void write_padding(SDL_IOStream* io, Uint64& cursor, Uint64 alignment) {
+    static const Uint8 zeros[SPRITE_PACK_ALIGN] = {};
+    Uint64 padding = (alignment - cursor % alignment) % alignment;
+    SDL_WriteIO(io, zeros, padding);
+    cursor += padding;
+}
+
+
+// Writes the built atlas (page surfaces still alive) as a pack, sprites sorted by name so the output is deterministic
+static bool write_sprite_pack(const char* path, Uint64 source_hash) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    if (io == nullptr) {
+        SDL_Log("Failed to write sprite pack. {%s}", SDL_GetError());
+        return false;
+    }
+
+    std::vector<const Sprite_sheet_data*> sorted;
+    for (const Sprite_sheet_data& spr : sprites) {
+        if (spr.sprite_id != 0) sorted.push_back(&spr);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Sprite_sheet_data* a, const Sprite_sheet_data* b) {
+        return a->sprite_name < b->sprite_name;
+    });
+
+    std::vector<Sprite_pack_sprite> sprites;
+    std::vector<Sprite_pack_frame> frames;
+    std::string names;
+    for (const Sprite_sheet_data* spr : sorted) {
+        Sprite_pack_sprite entry = {};
+        entry.name_offset = names.size();
+        entry.name_length = spr->sprite_name.size();
+        entry.first_frame = frames.size();
+        entry.frame_count = spr->frame_count;
+        entry.frame_w = spr->frame_size.x();
+        entry.frame_h = spr->frame_size.y();
+        entry.page = spr->page;
+        entry.fps = spr->fps;
+        entry.loop = spr->loop;
+        sprites.push_back(entry);
+        names += spr->sprite_name;
+
+        for (const Sprite_frame& frame : spr->frames) {
+            frames.push_back({
+                frame.location.x(), frame.location.y(),
+                frame.offset.x(), frame.offset.y(),
+                frame.size.x(), frame.size.y(),
+                frame.pivot.x(), frame.pivot.y(),
+                frame.duration, 0
+            });
+        }
+    }
+
+    Sprite_pack_header header = {};
+    header.magic = SPRITE_PACK_MAGIC;
+    header.version = SPRITE_PACK_VERSION;
+    header.source_hash = source_hash;
+    header.page_count = atlas_pages.size();
+    header.sprite_count = sprites.size();
+    header.frame_count = frames.size();
+    header.names_size = names.size();
+
+    // Pixel offsets are known up front, every page starts aligned
+    Uint64 cursor = sizeof(header) +
+        header.page_count * sizeof(Sprite_pack_page) +
+        sprites.size() * sizeof(Sprite_pack_sprite) +
+        frames.size() * sizeof(Sprite_pack_frame) +
+        names.size();
+    std::vector<Sprite_pack_page> pages;
+    for (const Atlas_page& page : atlas_pages) {
+        cursor += (SPRITE_PACK_ALIGN - cursor % SPRITE_PACK_ALIGN) % SPRITE_PACK_ALIGN;
+        Sprite_pack_page entry = {};
+        entry.width = page.surface->w;
+        entry.height = page.surface->h;
+        entry.pitch = page.surface->w * 4;
+        entry.pixel_offset = cursor;
+        pages.push_back(entry);
+        cursor += (Uint64)entry.pitch * entry.height;
+    }
+
+    SDL_WriteIO(io, &header, sizeof(header));
+    SDL_WriteIO(io, pages.data(), pages.size() * sizeof(Sprite_pack_page));
+    SDL_WriteIO(io, sprites.data(), sprites.size() * sizeof(Sprite_pack_sprite));
+    SDL_WriteIO(io, frames.data(), frames.size() * sizeof(Sprite_pack_frame));
+    SDL_WriteIO(io, names.data(), names.size());
+
+    // Row by row, the surface pitch may be padded
+    cursor = sizeof(header) + pages.size() * sizeof(Sprite_pack_page) + sprites.size() * sizeof(Sprite_pack_sprite) +
+        frames.size() * sizeof(Sprite_pack_frame) + names.size();
+    for (size_t i = 0; i < atlas_pages.size(); i++) {
+        const SDL_Surface* surface = atlas_pages[i].surface;
+        write_padding(io, cursor, SPRITE_PACK_ALIGN);
+        for (int y = 0; y < surface->h; y++) {
+            SDL_WriteIO(io, (const Uint8*)surface->pixels + y * surface->pitch, pages[i].pitch);
+        }
+        cursor += (Uint64)pages[i].pitch * pages[i].height;
+    }
+
+    bool ok = SDL_CloseIO(io);
+    if (!ok) SDL_Log("Failed to write sprite pack. {%s}", SDL_GetError());
+    return ok;
+}
+
+
+// Decodes a sprite file into an RGBA32 surface, safe to call from worker threads
+static SDL_Surface* decode_sprite(const std::string& sprite_file) {
+    SDL_Surface* loaded = IMG_Load((std::string(SPRITE_DIR) + sprite_file).c_str());
+    if (!loaded) {
         SDL_Log("Failed to load sprite sheet: {%s}", sprite_file.c_str());
+        return nullptr;
+    }
+
+    if (loaded->format == SDL_PIXELFORMAT_RGBA32) return loaded;
+    SDL_Surface* converted = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    return converted;
+}
+
+
+static Sprite_loop parse_loop(const std::string& name, bool& ok) {
+    if (name == "forward") return SPRITE_LOOP;
+    if (name == "once") return SPRITE_ONCE;
+    if (name == "pingpong") return SPRITE_PINGPONG;
+    ok = false;
+    return SPRITE_LOOP;
+}
+
+
+/**
+ * Reads the .sheet manifest of a sheet into its frame tables (see sheet_meta.hpp) and
+ * returns how many frames a row holds. Without a manifest, or with a broken one, the
+ * sheet is a single row of frame_count frames.
+ */
+static int load_sheet_manifest(const std::string& sprite_file, SDL_Surface* sheet, Sprite_sheet_data& data) {
+    data.frame_count = extract_frame_count(sprite_file);
+    data.frame_size = { sheet->w / SDL_max(data.frame_count, 1), sheet->h };
+    data.frames.assign(SDL_max(data.frame_count, 0), Sprite_frame{});
+
+    size_t size = 0;
+    char* file = (char*)SDL_LoadFile((std::string(SPRITE_DIR) + sheet_meta_file(sprite_file)).c_str(), &size);
+    if (file == nullptr) return data.frame_count;
+    std::istringstream lines(std::string(file, size));
+    SDL_free(file);
+
+    // Everything is read into locals first, a bad line leaves the sheet untouched
+    int frame_count = data.frame_count;
+    Vector2i frame_size = {0, 0};
+    int columns = 0;
+    int rows = 1;
+    int fps = data.fps;
+    Sprite_loop loop = data.loop;
+    Vector2i pivot = {0, 0};
+    struct Frame_entry { int index; int duration; bool has_pivot; Vector2i pivot; };
+    std::vector<Frame_entry> entries;
+
+    bool ok = true;
+    int line_number = 0;
+    for (std::string line; ok && std::getline(lines, line);) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive)) continue;
+
+        if (directive == "frames") ok = (bool)(in >> frame_count) && frame_count > 0;
+        else if (directive == "frame_size") ok = (bool)(in >> frame_size.x() >> frame_size.y()) && frame_size.minCoeff() > 0;
+        else if (directive == "grid") ok = (bool)(in >> columns >> rows) && columns > 0 && rows > 0;
+        else if (directive == "fps") ok = (bool)(in >> fps) && fps > 0 && fps <= 1000;     // Frames last whole milliseconds
+        else if (directive == "pivot") ok = (bool)(in >> pivot.x() >> pivot.y());
+        else if (directive == "loop") {
+            std::string mode;
+            ok = (bool)(in >> mode);
+            loop = parse_loop(mode, ok);
+        }
+        else if (directive == "frame") {
+            Frame_entry entry = {0, 0, false, {0, 0}};
+            ok = (bool)(in >> entry.index) && entry.index >= 0;
+            for (std::string key; ok && in >> key;) {
+                if (key == "duration") ok = (bool)(in >> entry.duration) && entry.duration > 0 && entry.duration <= UINT16_MAX;
+                else if (key == "pivot") {
+                    ok = (bool)(in >> entry.pivot.x() >> entry.pivot.y());
+                    entry.has_pivot = true;
+                }
+                else ok = false;
+            }
+            entries.push_back(entry);
+        }
+        else ok = false;
+    }
+
+    if (ok) {
+        if (columns == 0) columns = frame_count;
+        if (frame_size.x() == 0) frame_size = { sheet->w / columns, sheet->h / rows };
+        ok = columns * rows >= frame_count && frame_size.minCoeff() > 0 &&
+            columns * frame_size.x() <= sheet->w && rows * frame_size.y() <= sheet->h;
+        for (const Frame_entry& entry : entries) ok = ok && entry.index < frame_count;
+    }
+    if (!ok) {
+        SDL_Log("Invalid sheet manifest near line %d, reading the sheet as one row. {%s}", line_number, sprite_file.c_str());
+        return data.frame_count;
+    }
+
+    data.frame_count = frame_count;
+    data.frame_size = frame_size;
+    data.fps = fps;
+    data.loop = loop;
+    data.frames.assign(frame_count, Sprite_frame{});
+    for (Sprite_frame& frame : data.frames) frame.pivot = pivot;
+    for (const Frame_entry& entry : entries) {
+        Sprite_frame& frame = data.frames[entry.index];
+        if (entry.duration > 0) frame.duration = entry.duration;
+        if (entry.has_pivot) frame.pivot = entry.pivot;
+    }
+    return columns;
+}
+
+
+// A sheet's frames trimmed to their visible pixels, with repeats inside the sheet found
+struct Sheet_frames {
+    std::vector<Vector2i> origin;   // Top-left of the untrimmed frame on the sheet
+    std::vector<SDL_Rect> trimmed;
+    std::vector<Uint64> hashes;
+    std::vector<int> repeat_of;     // Earlier frame of this sheet with the same pixels, or -1
+    std::vector<bool> unique;       // Needs its own rect (not empty, not a repeat)
+};
+
+
+static void scan_frames(SDL_Surface* sheet, const Sprite_sheet_data& data, int columns, Sheet_frames& out) {
+    out.origin.assign(data.frame_count, Vector2i{0, 0});
+    out.trimmed.assign(data.frame_count, SDL_Rect{});
+    out.hashes.assign(data.frame_count, 0);
+    out.repeat_of.assign(data.frame_count, -1);
+    out.unique.assign(data.frame_count, false);
+
+    std::unordered_map<Uint64, int> first_with_hash;
+    for (int f = 0; f < data.frame_count; f++) {
+        out.origin[f] = {(f % columns) * data.frame_size.x(), (f / columns) * data.frame_size.y()};
+        SDL_Rect frame_rect = {out.origin[f].x(), out.origin[f].y(), data.frame_size.x(), data.frame_size.y()};
+        SDL_Rect& trimmed = out.trimmed[f];
+        trimmed = atlas_trim(sheet, frame_rect);
+        untrimmed_pixels += (Uint64)frame_rect.w * frame_rect.h;
+        trimmed_pixels += (Uint64)trimmed.w * trimmed.h;
+        if (trimmed.w == 0) continue;
+
+        // Idle holds and the like repeat a frame, only the first copy is packed
+        out.hashes[f] = atlas_hash_rect(sheet, trimmed);
+        auto it = first_with_hash.find(out.hashes[f]);
+        if (it != first_with_hash.end()) {
+            const SDL_Rect& first = out.trimmed[it->second];
+            if (first.w == trimmed.w && first.h == trimmed.h &&
+                atlas_rect_equal(sheet, trimmed, sheet, {first.x, first.y})) {
+                out.repeat_of[f] = it->second;
+                continue;
+            }
+        }
+        else {
+            first_with_hash[out.hashes[f]] = f;
+        }
+        out.unique[f] = true;
+    }
+}
+
+
+// Fills the untrimmed placement of a frame, returns false when it has nothing to store
+static bool init_frame(Sprite_sheet_data& data, const Sheet_frames& frames, int f) {
+    Sprite_frame& frame = data.frames[f];
+    const SDL_Rect& src = frames.trimmed[f];
+    frame.offset = Vector2i{src.x, src.y} - frames.origin[f];
+    frame.size = {src.w, src.h};
+    frame.location = {0, 0};
+    if (src.w == 0) return false;   // Fully transparent, nothing to store
+
+    if (frames.repeat_of[f] != -1) {
+        frame.location = data.frames[frames.repeat_of[f]].location;
+        atlas_stats.dedup_bytes += (Uint64)src.w * src.h * 4;
+        return false;
+    }
+    return true;
+}
+
+
+// Startup path, frames are blitted into the page surfaces and uploaded with the whole atlas
+static bool build_frames(SDL_Surface* sheet, Sprite_sheet_data& data, const Sheet_frames& frames) {
+    std::vector<Vector2i> shared(data.frame_count);
+    std::vector<Vector2i> packed;
+    if (!place_frames(sheet, frames.trimmed, frames.hashes, frames.unique, data.page, shared, packed)) return false;
+
+    // Blit the frames to the Texture_Atlas, repeated ones reuse the stored region
+    int pad = atlas_settings.padding;
+    data.frames.resize(data.frame_count);
+    int next = 0;
+    for (int f = 0; f < data.frame_count; f++) {
+        if (!init_frame(data, frames, f)) continue;
+        Sprite_frame& frame = data.frames[f];
+
+        if (shared[f].x() != -1) {
+            frame.location = shared[f];
+            atlas_stats.dedup_bytes += (Uint64)frame.size.x() * frame.size.y() * 4;
+            continue;
+        }
+
+        frame.location = packed[next++] + Vector2i(pad, pad);
+        atlas_blit(sheet, frames.trimmed[f], atlas_pages[data.page].surface, frame.location, pad);
+        stored_frames[frames.hashes[f]].push_back({data.page, frame.location, frame.size});
+    }
+    return true;
+}
+
+
+// Runtime pages start transparent and stay at full size, so sprites can keep coming and going
+static bool open_stream_page() {
+    if (atlas_pages.size() >= UINT8_MAX) return false;
+
+    atlas_pages.emplace_back();
+    Atlas_page& page = atlas_pages.back();
+    int size = atlas_settings.stream_page_size;
+    atlas_page_init(page, ATLAS_MAXRECTS, size, size);
+    page.streaming = true;
+    page.size = {size, size};
+
+    page.texture = SDL_CreateTexture(rend, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, size, size);
+    SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(page.texture, nullptr, page.surface->pixels, page.surface->pitch);
+    SDL_DestroySurface(page.surface);
+    page.surface = nullptr;
+    return true;
+}
+
+
+// Runtime path, every frame goes into a streaming page and only its own rect is uploaded
+static bool stream_frames(SDL_Surface* sheet, Sprite_sheet_data& data, const Sheet_frames& frames) {
+    int pad = atlas_settings.padding;
+    std::vector<Vector2i> sizes;
+    for (int f = 0; f < data.frame_count; f++) {
+        if (frames.unique[f]) sizes.push_back({frames.trimmed[f].w + pad * 2, frames.trimmed[f].h + pad * 2});
+    }
+
+    std::vector<Vector2i> packed;
+    int page = -1;
+    for (size_t i = 0; i < atlas_pages.size() && page == -1; i++) {
+        if (atlas_pages[i].streaming && atlas_page_pack_all(atlas_pages[i], sizes, packed)) page = i;
+    }
+    if (page == -1) {
+        if (!open_stream_page()) return false;
+        if (!atlas_page_pack_all(atlas_pages.back(), sizes, packed)) {
+            atlas_page_destroy(atlas_pages.back());
+            atlas_pages.pop_back();
+            return false;
+        }
+        page = atlas_pages.size() - 1;
+    }
+    data.page = page;
+
+    std::vector<SDL_Rect>& owned = streamed_rects[data.sprite_id];
+    data.frames.resize(data.frame_count);
+    int next = 0;
+    for (int f = 0; f < data.frame_count; f++) {
+        if (!init_frame(data, frames, f)) continue;
+        Sprite_frame& frame = data.frames[f];
+        const SDL_Rect& src = frames.trimmed[f];
+
+        // Extrude into a small staging surface, then upload the padded rect alone
+        SDL_Rect rect = {packed[next].x(), packed[next].y(), src.w + pad * 2, src.h + pad * 2};
+        next++;
+        SDL_Surface* staging = SDL_CreateSurface(rect.w, rect.h, SDL_PIXELFORMAT_RGBA32);
+        atlas_blit(sheet, src, staging, {pad, pad}, pad);
+        SDL_UpdateTexture(atlas_pages[page].texture, &rect, staging->pixels, staging->pitch);
+        SDL_DestroySurface(staging);
+
+        frame.location = {rect.x + pad, rect.y + pad};
+        owned.push_back(rect);
+    }
+
+    update_sprite_uv(data);
+    update_sprite_timeline(data);
+    return true;
+}
+
+
+// Packs an already decoded sheet into the atlas, takes ownership of the surface
+static void add_sprite_sheet(const std::string& sprite_file, SDL_Surface* sprite_sheet, int fps) {
+    std::string spr_name = extract_sprite_name(sprite_file);
+    Uint64 spr_id = hash_string(spr_name);
+    
+    // Already loaded, or another name with the same id
+    if (!sprite_id_free(spr_id, spr_name)) {
+        SDL_DestroySurface(sprite_sheet);
         return;
     }
 
@@ -220,28 +1058,367 @@ void sprite_add(const std::string sprite_file, int fps) {
     data.sprite_id = spr_id;
     data.sprite_name = spr_name;
     data.fps = fps;
-    data.loop = true;
-    data.frame_count = extract_frame_count(sprite_file);
+    data.loop = SPRITE_LOOP;
+    int columns = load_sheet_manifest(sprite_file, sprite_sheet, data);
+    if (data.frame_count <= 0) {
+        SDL_Log("Unknown frame count, expected spr_<name>_<frames>.png or a manifest. {%s}", sprite_file.c_str());
+        SDL_DestroySurface(sprite_sheet);
+        return;
+    }
 
-    Uint16 ss_width = sprite_sheet->w;
-    Uint16 ss_height = sprite_sheet->h;
-    data.frame_size = { ss_width / data.frame_count, ss_height };
+    // Trim every frame to its visible pixels, only those go into the atlas
+    Sheet_frames frames;
+    scan_frames(sprite_sheet, data, columns, frames);
+
+    bool placed = atlas_built ? stream_frames(sprite_sheet, data, frames) : build_frames(sprite_sheet, data, frames);
+    SDL_DestroySurface(sprite_sheet);
+    if (!placed) {
+        streamed_rects.erase(spr_id);
+        SDL_Log("No atlas space for sprite sheet {%s}", sprite_file.c_str());
+        return;
+    }
 
-    pack_sprite_sheet({ss_width, ss_height }, data.location);
-    sprite_sheet_map[spr_id] = data;
+    if (register_sprite(std::move(data)) == nullptr) {
+        // Streamed rects are handed back, startup ones stay unused in their page
+        auto owned = streamed_rects.find(spr_id);
+        if (owned != streamed_rects.end()) {
+            for (const SDL_Rect& rect : owned->second) {
+                atlas_page_free(atlas_pages[data.page], rect);
+            }
+            streamed_rects.erase(owned);
+        }
+        return;
+    }
+    SDL_Log("  > Sprite Loaded Succesfully. {%s}", spr_name.c_str());
+}
 
-    // Blit that surface to the Texture_Atlas
-    SDL_Rect dest = {
-        data.location.x(),
-        data.location.y(),
-        ss_width,
-        ss_height
-    };
 
-    SDL_BlitSurface(sprite_sheet, nullptr, surface_atlas, &dest);
+// True when another sprite points at one of this sprite's rects (startup dedup)
+static bool shares_rects(const Sprite_sheet_data& data) {
+    for (const Sprite_sheet_data& other : sprites) {
+        if (other.sprite_id == 0 || other.sprite_id == data.sprite_id || other.page != data.page) continue;
+        for (const Sprite_frame& a : other.frames) {
+            for (const Sprite_frame& b : data.frames) {
+                if (b.size.x() > 0 && a.location == b.location) return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+// Same frame sizes and the same repeats, so every new frame fits the rect of the old one
+static bool fits_in_place(const Sprite_sheet_data& old, const Sprite_sheet_data& data, const Sheet_frames& frames) {
+    if (old.frame_count != data.frame_count || old.frames.size() != (size_t)data.frame_count) return false;
+
+    for (int f = 0; f < data.frame_count; f++) {
+        const SDL_Rect& src = frames.trimmed[f];
+        if (old.frames[f].size != Vector2i(src.w, src.h)) return false;
+        if (src.w == 0) continue;
+
+        // The first earlier frame sharing its rect must be the one it now repeats
+        int old_first = -1;
+        for (int g = 0; g < f && old_first == -1; g++) {
+            if (old.frames[g].size.x() > 0 && old.frames[g].location == old.frames[f].location) old_first = g;
+        }
+        if (old_first != frames.repeat_of[f]) return false;
+    }
+    return !shares_rects(old);
+}
+
+
+// Patches the existing rects of a sheet with the new pixels, only those sub-rects are uploaded
+static void patch_frames(SDL_Surface* sheet, Sprite_sheet_data& data, const Sheet_frames& frames, const Sprite_sheet_data& old) {
+    int pad = atlas_settings.padding;
+    data.page = old.page;
+    data.frames.resize(data.frame_count);
+    Atlas_page& page = atlas_pages[data.page];
+    if (page.texture == nullptr) restore_page(page);
+    drop_page_mips(page);
+
+    for (int f = 0; f < data.frame_count; f++) {
+        if (!init_frame(data, frames, f)) continue;
+
+        const SDL_Rect& src = frames.trimmed[f];
+        Vector2i at = old.frames[f].location - Vector2i(pad, pad);
+        SDL_Rect rect = {at.x(), at.y(), src.w + pad * 2, src.h + pad * 2};
+        SDL_Surface* staging = SDL_CreateSurface(rect.w, rect.h, SDL_PIXELFORMAT_RGBA32);
+        atlas_blit(sheet, src, staging, {pad, pad}, pad);
+        SDL_UpdateTexture(atlas_pages[data.page].texture, &rect, staging->pixels, staging->pitch);
+        SDL_DestroySurface(staging);
+        data.frames[f].location = old.frames[f].location;
+    }
+    update_sprite_uv(data);
+    update_sprite_timeline(data);
+}
+
+
+/**
+ * Replaces a loaded sheet with a changed file. Same-sized frames are patched in
+ * place, otherwise the sheet is relocated into a streaming page. The map entry is
+ * updated in place, so entities pointing at it pick up the new frames and UVs.
+ */
+static void reload_sprite_sheet(const std::string& sprite_file, SDL_Surface* sprite_sheet) {
+    std::string spr_name = extract_sprite_name(sprite_file);
+    int slot = find_sprite(hash_string(spr_name));
+    if (slot == -1) {
+        add_sprite_sheet(sprite_file, sprite_sheet, 30);   // New file, same as a runtime sprite_add
+        return;
+    }
+
+    Sprite_sheet_data& old = sprites[slot];
+    Sprite_sheet_data data = {};
+    data.sprite_id = old.sprite_id;
+    data.sprite_name = old.sprite_name;
+    data.fps = old.fps;
+    data.loop = old.loop;
+    int columns = load_sheet_manifest(sprite_file, sprite_sheet, data);
+    if (data.frame_count <= 0) {
+        SDL_Log("Unknown frame count, keeping the loaded sheet. {%s}", sprite_file.c_str());
+        SDL_DestroySurface(sprite_sheet);
+        return;
+    }
+
+    Sheet_frames frames;
+    scan_frames(sprite_sheet, data, columns, frames);
+
+    bool in_place = fits_in_place(old, data, frames);
+    if (in_place) {
+        patch_frames(sprite_sheet, data, frames, old);
+    }
+    else {
+        // The old rects stay taken until the new frames are placed, the loaded sheet keeps drawing from them on failure
+        std::vector<SDL_Rect> old_rects;
+        auto owned = streamed_rects.find(old.sprite_id);
+        if (owned != streamed_rects.end()) {
+            old_rects = std::move(owned->second);
+            streamed_rects.erase(owned);
+        }
+
+        if (!stream_frames(sprite_sheet, data, frames)) {
+            SDL_Log("No atlas space to reload sprite sheet {%s}", sprite_file.c_str());
+            if (!old_rects.empty()) streamed_rects[old.sprite_id] = std::move(old_rects);
+            SDL_DestroySurface(sprite_sheet);
+            return;
+        }
+
+        // Startup rects stay behind in their baked page, streamed ones are given back
+        for (const SDL_Rect& rect : old_rects) {
+            atlas_page_free(atlas_pages[old.page], rect);
+        }
+    }
+
     SDL_DestroySurface(sprite_sheet);
-    SDL_Log("  > Sprite Loaded Succesfully. {%s}", spr_name.c_str());
-    return;
+    data.revision = ++sprite_revision;
+    old = std::move(data);
+    SDL_Log("  > Sprite Reloaded %s. {%s}", in_place ? "in place" : "to a new region", spr_name.c_str());
+}
+
+
+static void stream_worker_loop() {
+    std::unique_lock<std::mutex> lock(stream_mutex);
+    while (true) {
+        stream_cv.wait(lock, [] { return stream_quit || !stream_queue.empty(); });
+        if (stream_quit) return;
+
+        Stream_request request = stream_queue.front();
+        stream_queue.pop_front();
+        stream_decoding++;
+
+        // Decode without holding the lock, the main thread keeps queueing and uploading
+        lock.unlock();
+        request.surface = decode_sprite(request.file);
+        lock.lock();
+
+        stream_decoding--;
+        stream_ready.push_back(request);
+    }
+}
+
+
+void sprite_load_async(const std::string sprite_file, int fps) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    if (!stream_worker.joinable()) {
+        stream_quit = false;
+        stream_worker = std::thread(stream_worker_loop);
+    }
+    stream_queue.push_back({sprite_file, fps, nullptr, false});
+    stream_cv.notify_one();
+}
+
+
+void sprite_stream_update() {
+    Frame_vector<Stream_request> ready;
+    std::vector<Mip_job> mips;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        int take = SDL_min((int)stream_ready.size(), SPRITE_STREAM_BUDGET);
+        ready.assign(stream_ready.begin(), stream_ready.begin() + take);
+        stream_ready.erase(stream_ready.begin(), stream_ready.begin() + take);
+        mips.swap(mip_ready);
+    }
+
+    for (Mip_job& job : mips) {
+        upload_mips(job);
+    }
+    residency_frame++;
+    update_residency();
+
+    // fps and loop are public, timelines catch up with changes made through sprite_get
+    for (Sprite_sheet_data& spr : sprites) {
+        if (spr.sprite_id == 0) continue;
+        if (spr.timeline_fps != spr.fps || spr.timeline_loop != spr.loop) update_sprite_timeline(spr);
+    }
+
+    for (Stream_request& request : ready) {
+        if (request.surface == nullptr) continue;
+        if (request.reload) reload_sprite_sheet(request.file, request.surface);
+        else add_sprite_sheet(request.file, request.surface, request.fps);
+    }
+}
+
+
+int sprite_stream_pending() {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    return stream_queue.size() + stream_decoding + stream_ready.size();
+}
+
+
+// Decodes a changed file right on the watcher thread and hands it to sprite_stream_update
+static void queue_reload(const std::string& sprite_file) {
+    SDL_Surface* surface = decode_sprite(sprite_file);
+    if (surface == nullptr) return;     // Probably still being written, the next event retries
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    stream_ready.push_back({sprite_file, 30, surface, true});
+}
+
+
+#ifdef __linux__
+static void watch_loop() {
+    int fd = inotify_init1(IN_NONBLOCK);
+    if (fd < 0 || inotify_add_watch(fd, SPRITE_DIR, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        SDL_Log("Failed to watch {%s}", SPRITE_DIR);
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (!watch_quit) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;      // Wakes up regularly to notice watch_quit
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        std::vector<std::string> changed;
+        for (ssize_t i = 0; i < length;) {
+            const inotify_event* event = (const inotify_event*)(buffer + i);
+            i += sizeof(inotify_event) + event->len;
+            if (event->len == 0) continue;
+
+            // A rewritten sidecar reloads the sheet it describes
+            std::string file = event->name;
+            size_t ext = file.size() - SDL_strlen(SHEET_META_EXT);
+            if (file.size() > SDL_strlen(SHEET_META_EXT) && file.compare(ext, std::string::npos, SHEET_META_EXT) == 0) {
+                file = file.substr(0, ext) + ".png";
+            }
+            if (!is_sprite_file(file)) continue;
+            if (std::find(changed.begin(), changed.end(), file) == changed.end()) changed.push_back(file);
+        }
+
+        for (const std::string& file : changed) {
+            queue_reload(file);
+        }
+    }
+    close(fd);
+}
+#else
+// No inotify, compare modification times twice a second instead
+static void watch_loop() {
+    std::unordered_map<std::string, SDL_Time> stamps;
+    for (bool first = true; !watch_quit; first = false) {
+        for (const std::string& file : list_sprite_files()) {
+            SDL_PathInfo info;
+            if (!SDL_GetPathInfo((std::string(SPRITE_DIR) + file).c_str(), &info)) continue;
+            SDL_Time stamp = info.modify_time;
+            if (SDL_GetPathInfo((std::string(SPRITE_DIR) + sheet_meta_file(file)).c_str(), &info)) {
+                stamp = SDL_max(stamp, info.modify_time);     // A rewritten sidecar counts as a change too
+            }
+
+            auto it = stamps.find(file);
+            bool changed = !first && (it == stamps.end() || it->second != stamp);
+            stamps[file] = stamp;
+            if (changed) queue_reload(file);
+        }
+        for (int i = 0; i < 5 && !watch_quit; i++) SDL_Delay(100);
+    }
+}
+#endif
+
+
+void sprite_watch(bool enabled) {
+    if (enabled == watch_thread.joinable()) return;
+
+    if (enabled) {
+        watch_quit = false;
+        watch_thread = std::thread(watch_loop);
+    }
+    else {
+        watch_quit = true;
+        watch_thread.join();
+    }
+}
+
+
+void sprite_unload(const std::string& sprite_name) {
+    Uint64 spr_id = hash_string(sprite_name);
+    int slot = find_sprite(spr_id);
+    if (slot == -1) {
+        SDL_Log("Sprite {%s} is not loaded.", sprite_name.c_str());
+        return;
+    }
+
+    // Streamed sheets give their rects back, startup ones stay baked in their page
+    auto owned = streamed_rects.find(spr_id);
+    if (owned != streamed_rects.end()) {
+        Atlas_page& page = atlas_pages[sprites[slot].page];
+        for (const SDL_Rect& rect : owned->second) {
+            atlas_page_free(page, rect);
+        }
+        streamed_rects.erase(owned);
+    }
+    unregister_sprite(spr_id);
+}
+
+
+// Expects a Sprite_sheet
+// Sprite_id is the file_name
+// Adds this sprite_sheet to the Texture atlas
+//     example sprite_id: spr_player_5.png
+// Automatically assigns position for each individual sprite_sheet
+void sprite_add(const std::string sprite_file, int fps) {
+    SDL_Surface* sprite_sheet = decode_sprite(sprite_file);
+    if (sprite_sheet) add_sprite_sheet(sprite_file, sprite_sheet, fps);
+}
+
+
+// Narrows a destination rect meant for the untrimmed frame down to its trimmed pixels,
+// 'center' keeps the rotation around the middle of the untrimmed rect
+static SDL_FRect trimmed_dest(const Sprite_sheet_data& data, Uint8 index, SDL_FRect rect, SDL_FPoint& center) {
+    center = {rect.w / 2, rect.h / 2};
+    if (index >= data.frames.size()) return rect;
+
+    const Sprite_frame& frame = data.frames[index];
+    float sx = rect.w / data.frame_size.x();
+    float sy = rect.h / data.frame_size.y();
+    SDL_FRect out = {
+        rect.x + frame.offset.x() * sx,
+        rect.y + frame.offset.y() * sy,
+        frame.size.x() * sx,
+        frame.size.y() * sy
+    };
+
+    center = {rect.x + rect.w / 2 - out.x, rect.y + rect.h / 2 - out.y};
+    return out;
 }
 
 
@@ -252,13 +1429,19 @@ void draw_sprite(const Uint64 sprite_id, Uint8 index, float rotation,
     SDL_FRect src = sprite_frame_at(sprite_id, index);
     rect.x = r.x();
     rect.y = r.y();
+    rect.w *= cam.zoom;
+    rect.h *= cam.zoom;
+
+    const Sprite_sheet_data& data = sprite_get(sprite_id);
+    SDL_FPoint center;
+    SDL_FRect dest = trimmed_dest(data, index, rect, center);
 
     SDL_RenderTextureRotated(
         rend,
-        texture_atlas,
-        &src, &rect,
-        rotation,
-        NULL,
+        sprite_get_atlas(data.page),
+        &src, &dest,
+        rotation - cam.rotation,
+        &center,
         SDL_FLIP_NONE  
     );
 }
@@ -267,74 +1450,285 @@ void draw_sprite(const Uint64 sprite_id, Uint8 index, float rotation,
 void draw_sprite_raw(const Uint64 sprite_id, Uint8 index, float rotation, SDL_FRect rect) {
     SDL_FRect src = sprite_frame_at(sprite_id, index);
 
+    const Sprite_sheet_data& data = sprite_get(sprite_id);
+    SDL_FPoint center;
+    SDL_FRect dest = trimmed_dest(data, index, rect, center);
+
     SDL_RenderTextureRotated(
         rend,
-        texture_atlas,
-        &src, &rect,
+        sprite_get_atlas(data.page),
+        &src, &dest,
         rotation,
-        NULL,
+        &center,
         SDL_FLIP_NONE  
     );
 }
 
 
-void sprite_cleanup() {
-    SDL_DestroyTexture(texture_atlas);
-    SDL_DestroySurface(surface_atlas);
+// Builds every mip level of the startup pages, the heavy part of mipmapping stays off the main thread
+static void mip_worker_loop(std::vector<Mip_job> jobs) {
+    for (Mip_job& job : jobs) {
+        const SDL_Surface* from = mip_quit ? nullptr : job.source;
+        for (SDL_Surface*& level : job.levels) {
+            level = from ? atlas_downscale(from) : nullptr;
+            from = level;
+        }
+        SDL_DestroySurface(job.source);
+        job.source = nullptr;
+
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        mip_ready.push_back(job);
+    }
 }
 
 
-void load_all_sprite() {
-    // Load Every sprite asset found
-    DIR* dir = opendir(SPRITE_DIR);
-    if (dir == nullptr) {
-        SDL_Log("Directory not Found. {%s}", SPRITE_DIR);
-        return;
+// Hands the startup page surfaces (built or pointing into the pack) to the mip worker
+static void start_mip_worker() {
+    std::vector<Mip_job> jobs;
+    for (size_t i = 0; i < atlas_pages.size(); i++) {
+        Atlas_page& page = atlas_pages[i];
+        if (page.surface == nullptr || page.streaming) continue;
+        jobs.push_back({(int)i, page.surface, {}});
+        page.surface = nullptr;
     }
+    if (jobs.empty()) return;
+
+    mip_quit = false;
+    mip_worker = std::thread(mip_worker_loop, std::move(jobs));
+}
+
+
+static void stop_mip_worker() {
+    mip_quit = true;
+    if (mip_worker.joinable()) mip_worker.join();
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    for (Mip_job& job : mip_ready) {
+        for (SDL_Surface* level : job.levels) SDL_DestroySurface(level);
+    }
+    mip_ready.clear();
+}
 
-    // Folder walkthrough and get every frame as a surface
-    dirent* entity = readdir(dir);
-    while(entity != nullptr) {
 
-        // validate Sprite file
-        std::string img_path = (std::string(SPRITE_DIR) + entity->d_name);
-        if (img_path.find("spr_") != std::string::npos) {
+static void stop_stream_worker() {
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        stream_quit = true;
+    }
+    stream_cv.notify_all();
+    if (stream_worker.joinable()) stream_worker.join();
+
+    for (Stream_request& request : stream_ready) {
+        SDL_DestroySurface(request.surface);
+    }
+    stream_ready.clear();
+    stream_queue.clear();
+}
+
+
+void sprite_cleanup() {
+    sprite_watch(false);
+    stop_stream_worker();
+    stop_mip_worker();
+    for (Atlas_page& page : atlas_pages) {
+        atlas_page_destroy(page);
+    }
+    atlas_pages.clear();
+    unmap_file(pack_file);
+}
+
+
+static double ms_since(Uint64 start_ns) {
+    return (SDL_GetTicksNS() - start_ns) / 1e6;
+}
+
 
-            std::string file_name = std::string(entity->d_name);
-            SDL_Log("Adding Sprite Sheet {%s}", file_name.c_str());
-            sprite_add(file_name, 30); // fps default similar to GameMaker2
+// Indices of the decoded sheets in the order the packer should see them
+static std::vector<int> pack_order(const std::vector<SDL_Surface*>& decoded) {
+    std::vector<int> order;
+    for (size_t i = 0; i < decoded.size(); i++) {
+        if (decoded[i] != nullptr) order.push_back(i);
+    }
 
+    // Stable sort, so ties keep the file name order
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const SDL_Surface* sa = decoded[a];
+        const SDL_Surface* sb = decoded[b];
+        switch (atlas_settings.sort) {
+            case ATLAS_SORT_HEIGHT: return sa->h != sb->h ? sa->h > sb->h : sa->w > sb->w;
+            case ATLAS_SORT_AREA:   return sa->w * sa->h > sb->w * sb->h;
+            default:                return false;
         }
-        entity = readdir(dir);
+    });
+    return order;
+}
+
+
+static void report_packing(double pack_ms) {
+    Uint64 page_area = 0;
+    Uint64 packed_area = 0;
+    for (const Atlas_page& page : atlas_pages) {
+        page_area += (Uint64)page.used.x() * page.used.y();
+        packed_area += page.packed_area;
+    }
+
+    atlas_stats.page_count = atlas_pages.size();
+    atlas_stats.occupancy = page_area > 0 ? 100.0f * packed_area / page_area : 0.0f;
+    atlas_stats.pack_ms = pack_ms;
+    atlas_stats.trim_saved = untrimmed_pixels > 0 ? 100.0f * (untrimmed_pixels - trimmed_pixels) / untrimmed_pixels : 0.0f;
+
+    const char* packer = (atlas_settings.packer == ATLAS_SKYLINE) ? "Skyline" : "MaxRects";
+    SDL_Log("  > [Sprites] Pack + blit: %.2f ms {%s, %d pages, %.1f%% occupancy, %.1f%% trimmed, %.1f KB deduplicated}",
+        pack_ms, packer, atlas_stats.page_count, atlas_stats.occupancy, atlas_stats.trim_saved, atlas_stats.dedup_bytes / 1024.0);
+}
+
+
+// Decodes, packs and crops every sprite file into page surfaces, no GPU involved
+static bool build_atlas(const std::vector<std::string>& files) {
+    Uint64 phase = SDL_GetTicksNS();
+    std::vector<SDL_Surface*> decoded(files.size(), nullptr);
+    parallel_for(files.size(), [&](int i) {
+        decoded[i] = decode_sprite(files[i]);
+    });
+    SDL_Log("  > [Sprites] Decode: %.2f ms", ms_since(phase));
+
+    // Packing stays on this thread, in a stable order, so every run builds the same atlas
+    phase = SDL_GetTicksNS();
+    std::vector<int> order = pack_order(decoded);
+    for (int i : order) {
+        SDL_Log("Adding Sprite Sheet {%s}", files[i].c_str());
+        add_sprite_sheet(files[i], decoded[i], 30); // fps default similar to GameMaker2
+    }
+    report_packing(ms_since(phase));
+
+    if (live_sprites == 0) {
+        reset();
+        return false;
+    }
+    crop_pages();
+    return true;
+}
+
+
+static void drop_page_surfaces() {
+    for (Atlas_page& page : atlas_pages) {
+        SDL_DestroySurface(page.surface);
+        page.surface = nullptr;
+    }
+}
+
+
+void load_all_sprite() {
+    Uint64 phase = SDL_GetTicksNS();
+    std::vector<std::string> files = list_sprite_files();
+
+    // Shipped builds only carry the pack, it is trusted as is
+    if (files.empty()) {
+        if (!load_sprite_pack(SPRITE_PACK_FILE, 0, false)) SDL_Log("No sprites and no sprite pack found.");
+        return;
+    }
+
+    Uint64 source_hash = hash_sprite_files(files);
+    SDL_Log("  > [Sprites] Scan + hash: %.2f ms {%d files}", ms_since(phase), (int)files.size());
 
+    phase = SDL_GetTicksNS();
+    if (load_sprite_pack(SPRITE_PACK_FILE, source_hash, true) || load_sprite_pack(SPRITE_PACK_CACHE, source_hash, true)) {
+        SDL_Log("  > [Sprites] Pack map + upload: %.2f ms", ms_since(phase));
+        return;
     }
 
+    // Stale or missing pack, build the atlas from the PNGs
+    if (!build_atlas(files)) return;
+
+    phase = SDL_GetTicksNS();
     update_texture_atlas();
+    SDL_Log("  > [Sprites] Upload: %.2f ms", ms_since(phase));
+
+    phase = SDL_GetTicksNS();
+    SDL_CreateDirectory(ATLAS_CACHE_DIR);
+    if (write_sprite_pack(SPRITE_PACK_CACHE, source_hash)) map_pack_backing(SPRITE_PACK_CACHE);
+    SDL_Log("  > [Sprites] Cache write: %.2f ms", ms_since(phase));
+}
+
+
+bool sprite_pack_build(const std::string& output) {
+    reset();
+    std::vector<std::string> files = list_sprite_files();
+    bool ok = build_atlas(files) && write_sprite_pack(output.c_str(), hash_sprite_files(files));
+
+    drop_page_surfaces();
+    reset();
+    return ok;
 }
 
 
 void init_sprite_manager(SDL_Renderer* renderer) {
     rend = renderer;
 
+    stop_mip_worker();
     reset();
     load_all_sprite();
+
+    // The page surfaces go to the mip worker or away, sprites added from now on are streamed into their own pages
+    if (atlas_settings.mipmaps) start_mip_worker();
+    drop_page_surfaces();
+    stored_frames.clear();
+    atlas_built = true;
+}
+
+
+bool& sprite_atlas_dump() {
+    return atlas_dump;
+}
+
+
+Atlas_settings& sprite_atlas_settings() {
+    return atlas_settings;
+}
+
+
+const Atlas_stats& sprite_atlas_stats() {
+    return atlas_stats;
 }
 
 
 Sprite_sheet_data& sprite_get(const std::string& sprite_name) {
-    return sprite_sheet_map.at(hash_string(sprite_name));
+    return sprite_get(hash_string(sprite_name));
 }
 
 
 Sprite_sheet_data& sprite_get(const Uint64 sprite_id) {
-    return sprite_sheet_map.at(sprite_id);
+    int slot = find_sprite(sprite_id);
+    if (slot == -1) throw std::out_of_range("Sprite not loaded");
+    return sprites[slot];
+}
+
+
+SDL_Texture* sprite_get_atlas(int page, int mip) {
+    if (page < 0 || page >= (int)atlas_pages.size()) return nullptr;
+    Atlas_page& p = atlas_pages[page];
+    p.last_used = residency_frame;
+    if (p.texture == nullptr && p.backing != nullptr) restore_page(p);
+
+    // Falls back to the closest finer level until the worker has uploaded it
+    for (int level = SDL_min(mip, ATLAS_MIP_LEVELS - 1); level > 0; level--) {
+        if (p.mips[level - 1]) return p.mips[level - 1];
+    }
+    return p.texture;
+}
+
+
+int sprite_atlas_mip(float zoom) {
+    if (!atlas_settings.mipmaps || zoom <= 0) return 0;
+    int level = (int)SDL_floorf(std::log2(1.0f / zoom));
+    return SDL_clamp(level, 0, ATLAS_MIP_LEVELS - 1);
 }
 
 
-SDL_Texture* sprite_get_atlas() {
-    return texture_atlas;
+int sprite_atlas_page_count() {
+    return atlas_pages.size();
 }
 
 int sprite_count() {
-    return sprite_sheet_map.size();
+    return live_sprites;
 }
\ No newline at end of file
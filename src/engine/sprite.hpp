@@ -2,28 +2,76 @@
 #define SPRITE_HPP
 
 #include "camera.hpp"
+#include "atlas.hpp"
+#include "../utils/util.hpp"
 #include <SDL3/SDL.h>
 #include <string>
+#include <vector>
 #include <Eigen/Dense>
 using namespace Eigen;
+static const Uint16 MAX_SPRITES = 1024;
+
+
+/**
+ * @brief Compile-time sprite ID, "player"_spr == hash_string("player").
+ * 
+ * IDs are 64-bit FNV-1a hashes of the (lowercase) sprite name. Two names hashing
+ * alike are reported when the second one gets loaded.
+ */
+constexpr Uint64 operator""_spr(const char* name, size_t length) {
+    return hash_string(std::string_view(name, length));
+}
+
+
+/**
+ * @brief What an animation does after its last frame.
+ */
+enum Sprite_loop {
+    SPRITE_LOOP,            /**< Back to the first frame. */
+    SPRITE_ONCE,            /**< Holds the last frame. */
+    SPRITE_PINGPONG         /**< Plays backwards to the first frame, then forwards again. */
+};
+
+
+/**
+ * @brief One frame of a sprite sheet, trimmed to its non-transparent pixels.
+ *
+ * Only the trimmed rect is stored in the atlas. 'offset' places it back inside
+ * the untrimmed frame, so quads keep the same pivot as the original frame.
+ * Fully transparent frames have a size of 0 and are not drawn.
+ */
+struct Sprite_frame {
+    Vector2i location;          /**< Top-left of the trimmed pixels on the atlas page. */
+    Vector2i offset;            /**< Top-left of the trimmed pixels inside the untrimmed frame. */
+    Vector2i size;              /**< Size of the trimmed pixels. */
+    Vector2i pivot;             /**< Pivot inside the untrimmed frame, used by SPRITE_PIVOT entities (from the manifest). */
+    Uint16 duration;            /**< Milliseconds on screen, 0 to play it at the sheet's fps (from the manifest). */
+};
 
 
 /**
  * @brief Stores metadata and properties for a sprite sheet.
  * 
- * All sprites have Top-Left pivot points.
- * This pivot point is unrelated to rendering and entites.
- * They have their own ways of defining pivot point.
+ * Layout, timing and per-frame pivots come from the sheet's .sheet manifest when it has one
+ * (see sheet_meta.hpp). Entities only use the frame pivots with the SPRITE_PIVOT pivot type.
  */
 struct Sprite_sheet_data {
     Uint64 sprite_id;           /**< The HashID of a sprite sheet. */
     std::string sprite_name;    /**< The name of a sprite sheet. */
     int frame_count;            /**< Number of frames in the sprite sheet (auto-calculated). */
-    int fps;                    /**< Frames per second for animation (defaults to 30 fps). */
-    Vector2i location;          /**< Location of the sprite sheet on the texture atlas. */
-    Vector2i frame_size;        /**< Size of each frame in the sprite sheet (auto-calculated). */
-    Vector4f UV_coord;          /**< UV coordinates of the sprite sheet, from top-left to bottom-right. */
-    bool loop;                  /**< Whether the animation should loop (true by default). */
+    int fps;                    /**< Frames per second for frames without their own duration (defaults to 30 fps). */
+    Uint8 page;                 /**< The atlas page holding every frame of the sprite sheet. */
+    Vector2i frame_size;        /**< Untrimmed size of each frame in the sprite sheet (auto-calculated). */
+    std::vector<Sprite_frame> frames;   /**< Per frame atlas rect, trim offset, pivot and duration. */
+    std::vector<Vector4f> uvs;          /**< Per frame UVs of the trimmed pixels [Top-Left, Bottom-Right], indexed directly by the renderer. */
+    std::vector<SDL_FRect> rects;       /**< Per frame trimmed pixel rects on the atlas page. */
+    Sprite_loop loop;           /**< What happens after the last frame (SPRITE_LOOP by default). */
+    std::vector<Uint16> timeline;       /**< Frame index of every step of one cycle, ping-pong plays the inner frames twice. */
+    std::vector<Uint32> step_ends;      /**< Milliseconds from the start of the cycle to the end of every step. */
+    Uint32 step_ms = 0;                 /**< Duration shared by every step, 0 when frames have their own durations. */
+    int timeline_fps = 0;               /**< fps the timeline was built with, it is rebuilt once 'fps' or 'loop' change. */
+    Sprite_loop timeline_loop = SPRITE_LOOP;    /**< Loop mode the timeline was built with. */
+    Uint32 revision = 0;                /**< Changes whenever the frames are rebuilt (load, reload), caches of frame geometry compare it. */
 
     /**
      * @brief Calculates the total size of the sprite sheet.
@@ -32,26 +80,158 @@ struct Sprite_sheet_data {
     Vector2i sheet_size() const {
         return Vector2i(frame_size.x() * frame_count, frame_size.y());
     }
+
+    /**
+     * @brief How long a frame stays on screen.
+     * @param index The frame index.
+     * @return The frame's manifest duration, or 1000 / fps milliseconds (at least 1).
+     */
+    Uint32 frame_duration(int index) const {
+        if (index >= 0 && index < (int)frames.size() && frames[index].duration > 0) return frames[index].duration;
+        return SDL_max(1000 / SDL_max(fps, 1), 1);
+    }
+
+    /**
+     * @brief Evaluates the animation, without any per entity state.
+     * 
+     * Integer math only: a divide when every step lasts the same, otherwise a
+     * branchless count of the steps already over (vectorized by the compiler).
+     * 
+     * @param elapsed Milliseconds since the animation started.
+     * @return The frame index to draw.
+     */
+    int frame_at(Uint64 elapsed) const {
+        if (timeline.empty()) return 0;
+        Uint32 length = step_ends.back();
+        if (loop == SPRITE_ONCE && elapsed >= length) return timeline.back();
+
+        Uint32 t = (Uint32)(elapsed % length);
+        size_t step = 0;
+        if (step_ms > 0) {
+            step = t / step_ms;
+        } else {
+            for (Uint32 end : step_ends) step += (end <= t);
+        }
+        return timeline[step];
+    }
 };
 
 
 /**
  * @brief Loads all available sprites inside the asset folder.
+ * 
+ * The built atlas is baked into a sprite pack (assets/cache/sprites.pack). Later launches
+ * memory map it as long as the sprite files are unchanged, skipping PNG decoding and
+ * packing entirely. A shipped assets/sprites.pack takes precedence.
  * @param rend Pointer to the SDL_Renderer used for loading textures.
  */
 void init_sprite_manager(SDL_Renderer* rend);
 
 
+/**
+ * @brief Builds the atlas from assets/sprites/ and writes it as a sprite pack, without a renderer.
+ * 
+ * Used by the offline packer (tools/sprite_pack). A pack written to assets/sprites.pack
+ * is memory mapped at startup instead of decoding the PNGs, and is loaded on its own
+ * when the PNGs are not shipped.
+ * 
+ * @param output Path of the pack file to write.
+ * @return False when no sprite could be packed or the file can't be written.
+ */
+bool sprite_pack_build(const std::string& output);
+
+
+/**
+ * @brief Returns a reference to the atlas dump flag (off by default).
+ *        When set before init_sprite_manager, a freshly built atlas is also written to Texture_atlas_<page>.png.
+ * @return Reference to the flag.
+ */
+bool& sprite_atlas_dump();
+
+
+/**
+ * @brief Returns a reference to the atlas build settings (packer, sort, padding, page size).
+ *        Changing them before init_sprite_manager invalidates the atlas cache.
+ * @return Reference to the settings.
+ */
+Atlas_settings& sprite_atlas_settings();
+
+
+/**
+ * @brief Returns the page count, occupancy and packing time of the last atlas build, and the texture residency.
+ * @return The stats.
+ */
+const Atlas_stats& sprite_atlas_stats();
+
+
 /**
  * @brief Adds a sprite to the sprite manager.
  * 
- * sprite_file follows this naming convention: <<spr_name_5.png>> where '5' is the number of frames
+ * sprite_file follows this naming convention: <<spr_name_5.png>> where '5' is the number of frames.
+ * After startup the sprite is streamed into a runtime atlas page, decoding happens on the calling thread.
  * @param sprite_file The file name of the sprite under "assets/sprites" directory.
- * @param fps Frames per second for the sprite animation.
+ * @param fps Frames per second for the sprite animation, unless its manifest sets one.
  */
 void sprite_add(const std::string sprite_file, int fps);
 
 
+/**
+ * @brief Queues a sprite to be decoded on a background thread.
+ * 
+ * Once decoded, sprite_stream_update packs it into a streaming atlas page and
+ * uploads only the rects of its frames, so levels can lazy-load their content
+ * without stalling a frame. The sprite is usable once sprite_stream_pending()
+ * no longer counts it.
+ * 
+ * @param sprite_file The file name of the sprite under "assets/sprites" directory.
+ * @param fps Frames per second for the sprite animation, unless its manifest sets one.
+ */
+void sprite_load_async(const std::string sprite_file, int fps);
+
+
+/**
+ * @brief Uploads sprites decoded by sprite_load_async (a few per call). Call once per frame.
+ * 
+ * Animation timelines of sprites whose fps or loop mode changed are rebuilt here as well.
+ * 
+ * Also keeps the atlas under Atlas_settings::texture_budget: pages not drawn since the
+ * last call are evicted least recently used first. Only pages mapped from the sprite pack
+ * can be evicted, sprite_get_atlas uploads them again the next time they are drawn.
+ */
+void sprite_stream_update();
+
+
+/**
+ * @brief Returns the number of async sprite loads that are not usable yet.
+ * @return Queued, decoding and waiting for upload.
+ */
+int sprite_stream_pending();
+
+
+/**
+ * @brief Starts or stops hot reloading of assets/sprites/ (off by default).
+ * 
+ * Changed files are re-decoded on a watcher thread (inotify on Linux, modification
+ * time polling elsewhere) and applied by sprite_stream_update. Frames keeping their
+ * size are patched in place, others are moved to a streaming page. Entities refer
+ * to the sprite manager's data, so they show the new frames without respawning.
+ * 
+ * @param enabled Whether the watcher should run.
+ */
+void sprite_watch(bool enabled);
+
+
+/**
+ * @brief Removes a sprite from the sprite manager.
+ * 
+ * Sprites loaded after startup give their atlas space back for later loads.
+ * Entities referring to the sprite must be destroyed first.
+ * 
+ * @param sprite_name The sprite name (All letters are Lowercase).
+ */
+void sprite_unload(const std::string& sprite_name);
+
+
 /**
  * @brief Cleans up and releases all sprite resources.
  */
@@ -59,7 +239,7 @@ void sprite_cleanup();
 
 
 /**
- * @brief Gets the rectangle for a specific frame of a sprite.
+ * @brief Gets the atlas rectangle for a specific frame of a sprite (trimmed).
  * @param sprite_id The ID of the sprite.
  * @param index The frame index.
  * @return SDL_FRect representing the frame's position and size.
@@ -68,7 +248,7 @@ SDL_FRect sprite_frame_at(const Uint64 sprite_id, Uint16 index);
 
 
 /**
- * @brief Gets the UV coordinates for a specific frame of a sprite.
+ * @brief Gets the UV coordinates for a specific frame of a sprite (trimmed).
  * @param sprite_id The ID of the sprite.
  * @param index The frame index.
  * @return Vector4f containing the UV coordinates [Top-Left, Bottom-Right].
@@ -77,14 +257,40 @@ Vector4f sprite_frame_at_uv(const Uint64 sprite_id, Uint16 index);
 
 
 /**
- * @brief Gets the texture atlas containing all sprites.
- * @return Pointer to the SDL_Texture atlas.
+ * @brief Gets one page of the texture atlas.
+ * 
+ * Every mip level covers the same UVs, so quads keep their UV tables whatever the level.
+ * Levels that aren't generated (yet) fall back to the closest finer one.
+ * 
+ * @param page The page index (see Sprite_sheet_data::page).
+ * @param mip 0 for full resolution, 1 for half, 2 for quarter (see sprite_atlas_mip).
+ * @return Pointer to the SDL_Texture page, nullptr if out of range.
  */
-SDL_Texture* sprite_get_atlas();
+SDL_Texture* sprite_get_atlas(int page = 0, int mip = 0);
+
+
+/**
+ * @brief Picks the atlas mip level for a camera zoom, the finest level still at least as large on screen.
+ * @param zoom The camera zoom (< 1 zooms out).
+ * @return 0 above zoom 0.5, 1 above 0.25, 2 at or below it, always 0 when Atlas_settings::mipmaps is off.
+ */
+int sprite_atlas_mip(float zoom);
+
+
+/**
+ * @brief Returns the number of atlas pages.
+ * @return The page count.
+ */
+int sprite_atlas_page_count();
 
 
 /**
  * @brief Retrieves the Sprite_sheet_data for a given sprite.
+ * 
+ * Sprites live in a dense array of MAX_SPRITES slots, the reference stays valid
+ * until the sprite is unloaded (hot reloads update it in place).
+ * Throws std::out_of_range when the sprite isn't loaded.
+ * 
  * @param sprite_name The name of the sprite.
  * @return Reference to the Sprite_sheet_data.
  */
@@ -93,7 +299,8 @@ Sprite_sheet_data& sprite_get(const std::string& sprite_name);
 
 /**
  * @brief Retrieves the Sprite_sheet_data for a given sprite.
- * @param sprite_id The ID of the sprite.
+ *        The ID resolves to its slot through a flat open addressing table, no hashing of names.
+ * @param sprite_id The ID of the sprite (e.g. "player"_spr).
  * @return Reference to the Sprite_sheet_data.
  */
 Sprite_sheet_data& sprite_get(const Uint64 sprite_id);
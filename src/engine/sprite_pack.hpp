@@ -0,0 +1,69 @@
+#ifndef SPRITE_PACK_HPP
+#define SPRITE_PACK_HPP
+
+#include <SDL3/SDL.h>
+
+#define SPRITE_PACK_MAGIC 0x4B505053        // "SPPK"
+#define SPRITE_PACK_VERSION 3
+#define SPRITE_PACK_ALIGN 64                // Pixel blobs start on a cache line
+#define SPRITE_PACK_FILE "assets/sprites.pack"          // Shipped pack, built by tools/sprite_pack
+#define SPRITE_PACK_CACHE "assets/cache/sprites.pack"   // Rebuilt at startup whenever the sprite files change
+
+/**
+ * Pre-decoded sprite pack, the atlas exactly as it gets uploaded.
+ * The file is memory mapped and every page goes straight from the mapping
+ * into SDL_UpdateTexture, so loading does no decoding and no copies.
+ *
+ * Layout (native endianness, every table 8 byte aligned):
+ *   Sprite_pack_header
+ *   page_count   x Sprite_pack_page
+ *   sprite_count x Sprite_pack_sprite     (sorted by name)
+ *   frame_count  x Sprite_pack_frame      (each sprite owns a contiguous run)
+ *   names_size bytes of sprite names, not null terminated
+ *   page_count x { height * pitch bytes of RGBA32 pixels, SPRITE_PACK_ALIGN aligned }
+ */
+struct Sprite_pack_header {
+    Uint32 magic;
+    Uint32 version;
+    Uint64 source_hash;     // Hash of the sprite files and atlas settings the pack was built from
+    Uint32 page_count;
+    Uint32 sprite_count;
+    Uint32 frame_count;     // Over every sprite
+    Uint32 names_size;
+};
+
+struct Sprite_pack_page {
+    Uint32 width;
+    Uint32 height;
+    Uint32 pitch;           // Bytes per row, >= width * 4
+    Uint32 reserved;
+    Uint64 pixel_offset;    // From the start of the file
+};
+
+struct Sprite_pack_sprite {
+    Uint32 name_offset;     // Into the name blob
+    Uint32 name_length;
+    Uint32 first_frame;     // Into the frame table
+    Sint32 frame_count;
+    Sint32 frame_w;         // Untrimmed frame size
+    Sint32 frame_h;
+    Uint32 page;
+    Uint16 fps;
+    Uint16 loop;            // Sprite_loop
+};
+
+struct Sprite_pack_frame {
+    Sint32 x, y;            // Trimmed pixels on the page
+    Sint32 offset_x, offset_y;
+    Sint32 w, h;
+    Sint32 pivot_x, pivot_y;
+    Uint32 duration;        // Milliseconds, 0 plays it at the sprite's fps
+    Uint32 reserved;
+};
+
+static_assert(sizeof(Sprite_pack_header) == 32, "Sprite pack header layout changed");
+static_assert(sizeof(Sprite_pack_page) == 24, "Sprite pack page layout changed");
+static_assert(sizeof(Sprite_pack_sprite) == 32, "Sprite pack sprite layout changed");
+static_assert(sizeof(Sprite_pack_frame) == 40, "Sprite pack frame layout changed");
+
+#endif
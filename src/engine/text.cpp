@@ -0,0 +1,188 @@
+#include "text.hpp"
+#include "renderer.hpp"
+#include "sprite.hpp"
+#include "../utils/util.hpp"
+#include <SDL3/SDL.h>
+#include <Eigen/Dense>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <string_view>
+using namespace Eigen;
+
+/**
+ * A laid out string: one box per visible glyph, relative to the top-left of the
+ * text block at scale 1. UVs are read from the sprite when drawing, so a glyph
+ * sheet relocated to another page is still drawn right.
+ */
+struct Glyph_run {
+    std::string text;               // The string, to tell apart strings hashing alike
+    std::vector<Vector4f> boxes;    // Per glyph [Top-Left, Bottom-Right]
+    std::vector<Uint16> glyphs;     // Per glyph frame index
+    Vector2f size;                  // Unscaled size of the text block
+    Vector2f advance;               // Font advance the run was laid out with
+    Uint32 revision;                // Sprite revision the run was laid out from
+    Uint64 last_used;               // Cache frame this run was last drawn on
+};
+
+struct Font_slot {
+    Font font;
+    bool used = false;
+    std::unordered_map<Uint64, Glyph_run> runs;     // Keyed by hash_string, lookups don't allocate
+};
+
+static Font_slot fonts[MAX_FONTS];
+static Uint64 cache_frame = 0;
+
+
+static Vector2f layout_size(const Font& font, std::string_view str) {
+    int columns = 0;
+    int max_columns = 0;
+    int lines = 1;
+
+    for (char ch : str) {
+        if (ch == '\n') {
+            lines++;
+            columns = 0;
+            continue;
+        }
+        columns++;
+        if (columns > max_columns) max_columns = columns;
+    }
+    return Vector2f(max_columns * font.advance.x(), lines * font.advance.y());
+}
+
+
+static void layout_run(const Font& font, const Sprite_sheet_data& spr, std::string_view str, Glyph_run& run) {
+    Vector2f pen = {0, 0};
+
+    run.text = str;
+    run.boxes.clear();
+    run.glyphs.clear();
+    run.size = layout_size(font, str);
+    run.advance = font.advance;
+    run.revision = spr.revision;
+
+    for (char ch : str) {
+        if (ch == '\n') {
+            pen.x() = 0;
+            pen.y() += font.advance.y();
+            continue;
+        }
+
+        int glyph = (unsigned char)ch - (unsigned char)font.first_char;
+        // Fully transparent glyphs were trimmed away, they only advance the pen
+        if (ch != ' ' && glyph >= 0 && glyph < spr.frame_count && spr.frames[glyph].size.x() > 0) {
+            const Sprite_frame& frame = spr.frames[glyph];
+            float x = pen.x() + frame.offset.x();
+            float y = pen.y() + frame.offset.y();
+            run.boxes.push_back({x, y, x + frame.size.x(), y + frame.size.y()});
+            run.glyphs.push_back(glyph);
+        }
+        pen.x() += font.advance.x();
+    }
+}
+
+
+int text_font_add(const std::string& sprite_name, char first_char) {
+    for (int id = 0; id < MAX_FONTS; id++) {
+        Font_slot& slot = fonts[id];
+        if (slot.used) continue;
+
+        const Sprite_sheet_data& spr = sprite_get(sprite_name);
+        slot.used = true;
+        slot.runs.clear();
+        slot.font.sprite_id = spr.sprite_id;
+        slot.font.first_char = first_char;
+        slot.font.advance = Vector2f(spr.frame_size.x(), spr.frame_size.y());
+        return id;
+    }
+
+    SDL_Log("Font limit reached. {%d}", MAX_FONTS);
+    return -1;
+}
+
+
+static bool valid_font(int font_id) {
+    if (font_id >= 0 && font_id < MAX_FONTS && fonts[font_id].used) return true;
+    SDL_Log("Font not found. {%d}", font_id);
+    return false;
+}
+
+
+Font& text_font_get(int font_id) {
+    if (!valid_font(font_id)) throw std::out_of_range("Font not found");
+    return fonts[font_id].font;
+}
+
+
+Vector2f text_measure(int font_id, std::string_view str) {
+    if (!valid_font(font_id)) return Vector2f(0, 0);
+    return layout_size(fonts[font_id].font, str);
+}
+
+
+void text_draw(int font_id, std::string_view str, Vector2f position, float scale,
+    SDL_FColor color, Pivot_Type pivot, Uint16 depth) {
+
+    if (!valid_font(font_id)) return;
+    Font_slot& slot = fonts[font_id];
+    const Sprite_sheet_data& spr = sprite_get(slot.font.sprite_id);
+    auto [it, added] = slot.runs.try_emplace(hash_string(str));
+    Glyph_run& run = it->second;
+
+    // New string, font tweaked or glyph sheet reloaded since the last layout
+    if (added || run.advance != slot.font.advance || run.revision != spr.revision || run.text != str) {
+        layout_run(slot.font, spr, str, run);
+    }
+    run.last_used = cache_frame;
+
+    Vector2f origin = position - get_pivot_offset(pivot, run.size * scale);
+    int glyphs = run.glyphs.size();
+    SDL_Vertex* v = render_batch_quads_begin(depth, glyphs, spr.page);
+
+    for (int i = 0; i < glyphs; i++) {
+        const Vector4f& uv = spr.uvs[run.glyphs[i]];
+        Vector4f box = run.boxes[i] * scale;
+        float x = origin.x();
+        float y = origin.y();
+
+        v[0] = {{x + box.x(), y + box.y()}, color, {uv.x(), uv.y()}};    // Top left
+        v[1] = {{x + box.z(), y + box.y()}, color, {uv.z(), uv.y()}};    // Top right
+        v[2] = {{x + box.z(), y + box.w()}, color, {uv.z(), uv.w()}};    // Bottom right
+        v[3] = {{x + box.x(), y + box.w()}, color, {uv.x(), uv.w()}};    // Bottom left
+        v += 4;
+    }
+    render_batch_quads_end(depth, glyphs);
+}
+
+
+void text_cache_trim() {
+    // Scanning every run each frame is wasted work, once a second is plenty
+    cache_frame++;
+    if (cache_frame % 60 != 0) return;
+
+    for (Font_slot& slot : fonts) {
+        for (auto it = slot.runs.begin(); it != slot.runs.end();) {
+            if (cache_frame - it->second.last_used > TEXT_CACHE_FRAMES) it = slot.runs.erase(it);
+            else ++it;
+        }
+    }
+}
+
+
+int text_cache_count() {
+    int total = 0;
+    for (const Font_slot& slot : fonts) {
+        total += slot.runs.size();
+    }
+    return total;
+}
+
+
+void text_cleanup() {
+    for (Font_slot& slot : fonts) {
+        slot = Font_slot{};
+    }
+}
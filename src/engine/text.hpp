@@ -0,0 +1,91 @@
+#ifndef TEXT_HPP
+#define TEXT_HPP
+
+#include "../utils/util.hpp"
+#include <SDL3/SDL.h>
+#include <string>
+#include <string_view>
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#define MAX_FONTS 16
+#define TEXT_CACHE_FRAMES 300   // Glyph runs unused for this many frames are evicted
+
+/**
+ * @brief A monospaced bitmap font backed by a sprite sheet.
+ *
+ * The font is a regular sprite (spr_<name>_<N>.png) so its glyphs get packed into
+ * the texture atlas like any other sheet. Frame 0 is 'first_char', frame 1 is
+ * 'first_char + 1' and so on, e.g. spr_font_95.png covers ' ' up to '~'.
+ */
+struct Font {
+    Uint64 sprite_id;           /**< The sprite sheet holding the glyphs. */
+    char first_char = ' ';      /**< The character stored at frame 0. */
+    Vector2f advance;           /**< Horizontal advance and line height (defaults to the frame size). */
+};
+
+
+/**
+ * @brief Registers a sprite sheet as a bitmap font.
+ * @param sprite_name The sprite name (All letters are Lowercase).
+ * @param first_char The character stored in the first frame.
+ * @return The font ID, or -1 when MAX_FONTS is reached.
+ */
+int text_font_add(const std::string& sprite_name, char first_char);
+
+
+/**
+ * @brief Retrieves a font, e.g. to tweak its advance.
+ *        Throws std::out_of_range for an unknown ID (e.g. the -1 of a failed add).
+ * @param font_id The font ID.
+ * @return Reference to the Font.
+ */
+Font& text_font_get(int font_id);
+
+
+/**
+ * @brief Measures the size of a string without drawing it.
+ * @param font_id The font ID.
+ * @param str The text, '\n' starts a new line.
+ * @return The unscaled width and height of the text block, {0, 0} for an unknown font ID.
+ */
+Vector2f text_measure(int font_id, std::string_view str);
+
+
+/**
+ * @brief Batches a string as glyph quads into a depth batch.
+ *
+ * The glyph layout of every string is cached, so drawing the same string again
+ * only offsets, scales and tints the cached quads.
+ *
+ * @param font_id The font ID, unknown IDs are logged and nothing is drawn.
+ * @param str The text, '\n' starts a new line.
+ * @param position World position of the pivot.
+ * @param scale Scale factor of the glyphs.
+ * @param color Color blend of the glyphs.
+ * @param pivot The point where position rests.
+ * @param depth Rendering depth.
+ */
+void text_draw(int font_id, std::string_view str, Vector2f position, float scale, SDL_FColor color, Pivot_Type pivot, Uint16 depth);
+
+
+/**
+ * @brief Advances the cache clock and evicts glyph runs that were not drawn recently.
+ *        Call once per frame.
+ */
+void text_cache_trim();
+
+
+/**
+ * @brief Returns the number of cached glyph runs across all fonts.
+ * @return The cached run count.
+ */
+int text_cache_count();
+
+
+/**
+ * @brief Releases all fonts and cached glyph runs.
+ */
+void text_cleanup();
+
+#endif
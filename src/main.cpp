@@ -34,24 +34,35 @@ using namespace Eigen;
 #include "engine/renderer.hpp"
 #include "engine/sprite.hpp"
 #include "engine/entity.hpp"
+#include "engine/particle.hpp"
+#include "engine/text.hpp"
+#include "engine/scene.hpp"
 #include "core/input.hpp"
+#include "core/timestep.hpp"
+#include "core/pacer.hpp"
+#include "core/jobs.hpp"
 #include "utils/util.hpp"
 
 // Constants ========
-#define FPS 60
-#define MS_PER_FRAME 1000 / FPS
+#define TICK_RATE 60                // Simulation updates per second, rendering runs at the display rate
+#define MAX_CATCH_UP 5              // Updates per frame at most after a stall
 #define WIN_TITLE "Spright2D v.1.0"
 #define WIN_WIDTH 1920
 #define WIN_HEIGHT 1080
-#define STAT_COUNT 7
+#define STAT_COUNT 13
+#define ENTITY_JOB_GRAIN 128        // Entities per job in the cull / transform pass
+#define STRESS_PARTICLES 1000000    // Particles kept alive by the stress emitter
 
 // Struct for handling state for each scene
 struct global_state {
     /* States */
 };
 
-struct local_state {
+struct local_state {            // Allocated in the scene's arena, gone when the scene unloads
     /* States */
+    int spawn_time = 0;
+    int spark_emitter = -1;
+    int stress_emitter = -1;    // B toggles it, to check the particle budget
 };
 
 // Add Global variables, this variables are available to all scenes.
@@ -65,23 +76,35 @@ UIManager ui_manager;
 char dbg_stats[STAT_COUNT][64]; // 64 bytes per line, tweak as needed
 
 bool game_running = true;   // Stop or Continue Game loop
-bool invokeStart = true;    // Resets every Scene Change, on True call start
-float current_fps = 0.0f;   // Non-capped FPS
-Uint32 delta_time;          // Measured in Milliseconds
-Uint32 frame_count = 0;
-Uint32 frame_timer = 0;
+global_state game_state = {};
 Camera camera = {
     {-WIN_WIDTH/2, -WIN_HEIGHT/2},
     {WIN_WIDTH, WIN_HEIGHT}
 };
+Camera minimap = {                  // Second viewport, follows the main camera
+    {0, 0},
+    {WIN_WIDTH/4, WIN_HEIGHT/4},
+    0.125f, 0,
+    {WIN_WIDTH - WIN_WIDTH/4 - 16, WIN_HEIGHT - WIN_HEIGHT/4 - 16}
+};
+bool show_minimap = false;
+Camera camera_prev = camera;        // Cameras at the previous tick, for render interpolation
+Camera minimap_prev = minimap;
+double particle_update_ms = 0;      // Particle costs of the last tick / frame, for the debug stats
+double particle_submit_ms = 0;
 
 // Cache sprite IDs
-Uint64 spr_player = hash_string("player");
+Uint64 spr_player = "player"_spr;
 
 // Function Declarations
 void app_quit();
 void config_sprite();
-void load_entities();
+void preload(Scene& scene);
+void start(Scene& scene);
+void update(Scene& scene, float dt);
+void render(Scene& scene);
+void draw_backdrop();
+void unload(Scene& scene);
 
 // Initiate SDL3, Window, and Renderer
 void init() {
@@ -101,12 +124,15 @@ void init() {
         app_quit();
     }
 
-    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
     renderer = SDL_CreateRenderer(win, NULL);
     if (renderer == nullptr) {
         SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create renderer.");
         app_quit();
     }
+    pacer_init(renderer);            // VSync by default, P cycles uncapped / capped / vsync
+
+    // Workers for sprite decoding and the per-frame entity pass, the main thread helps while waiting
+    jobs_init();                     // Scheduling overhead: make jobbench && cd bin && jobbench.exe
 
     // Initialize ImGui
     IMGUI_CHECKVERSION();
@@ -118,13 +144,15 @@ void init() {
     ImGui_ImplSDLRenderer3_Init(renderer);
 
     // Initialization of System (Peak shit🙏🙏)
+    // sprite_atlas_dump() = true;   // Write Texture_atlas_<page>.png whenever the atlas gets rebuilt
     init_sprite_manager(renderer);   // Load all sprite_sheets
+    sprite_watch(true);              // Hot reload edited sprite sheets
     config_sprite();
     render_init(renderer);
     flip_event(DEBUG_MODE);          // Initially start with debug mode
 
-    //  >>>> You wanna Generate some sprite_sheets? Do it below. <<<<<<   
-    // generate_sprite_sheet("dir", "spr_output_0.png");
+    //  >>>> You wanna Generate some sprite_sheets? Use the sheetgen tool. <<<<<<
+    // make sheetgen && cd bin && sheetgen.exe assets/temp/player assets/sprites/spr_player
 }
 
 // FPS and shits
@@ -134,27 +162,56 @@ void config_sprite() {
     sprite_get("player").fps    = 6;
 }
 
-void load_entities() {
+// Scene preload (loading thread) ================================================
+void preload(Scene& scene) {
+    scene.state = arena_new<local_state>(*scene.arena);
+
     // Base Scene
     entity_spawn("player", {150, 300}, {2, 2}, 0, MIDDLE_CENTER, 200);
+    for (int i = 0; i < 20; i++) {
+        entity_spawn("cat", {i * 96.0f - 960, 420}, {1, 1}, 0, TOP_LEFT, 100);
+    }
 }
 
 
 // Scene start ====================================================================
-void start() { 
-    /* CODE */
+void start(Scene& scene) { 
+    local_state& ls = *(local_state*)scene.state;
+
+    // Spawned enemies and cats overlap by where they stand
+    render_layer_add("actors", 100, {1, 1}, false);
+    render_layer_get("actors").y_sort = true;
+
+    // Far backdrop, scrolls at half speed and is baked once
+    render_layer_add("backdrop", 50, {0.5f, 0.5f}, true);
+
+    Particle_emitter sparks;
+    sparks.sprite_id    = "enemy"_spr;
+    sparks.depth        = 300;
+    sparks.capacity     = 100000;
+    sparks.velocity_min = {-200, -350};
+    sparks.velocity_max = {200, -50};
+    sparks.gravity      = {0, 600};
+    sparks.life_min     = 0.5f;
+    sparks.life_max     = 1.5f;
+    sparks.size_start   = 0.5f;
+    sparks.size_end     = 0.1f;
+    ls.spark_emitter = particle_emitter_add(sparks);
 }
 
-// Runs per frame =====================================================================
-int spwn_time = 0;
-void update(global_state& gs, local_state& ls) {
+// Runs per tick ======================================================================
+void update(Scene& scene, float dt) {
+    global_state& gs = game_state;
+    local_state& ls = *(local_state*)scene.state;
+    (void)gs;
+
     /* CODE */
     Vector2f m_w = screen_to_world(camera, mouse_pos());
 
     // Entity Clicking
     int ent_id = -1;
-    for (auto& [key, ent] : entity_get_map()) {
-        int w = ent.scale.x() * ent.sprite.frame_size.x();
+    for (Entity& ent : entity_all()) {
+        int w = ent.scale.x() * ent.sprite->frame_size.x();
         if (distance(m_w, ent.position) < w && is_event_active(MOUSE_RIGHT_PRESSED) && ent_id == -1) {
             ent_id = ent.id;
         }
@@ -173,7 +230,7 @@ void update(global_state& gs, local_state& ls) {
     
     if (is_event_active(MOUSE_LEFT_PRESSED)) {
         Entity& e = entity_get(0);
-        Vector2i h_size = e.sprite.frame_size / 2;
+        Vector2i h_size = e.sprite->frame_size / 2;
         e.position.x() = m_w.x();
         e.position.y() = m_w.y();
     }
@@ -189,40 +246,118 @@ void update(global_state& gs, local_state& ls) {
     if (check_key(SDL_SCANCODE_A)) camera.move({-cam_spd,  0        });
     if (check_key(SDL_SCANCODE_S)) camera.move({0       ,  cam_spd  });
     if (check_key(SDL_SCANCODE_D)) camera.move({cam_spd ,  0        });
+    if (check_key(SDL_SCANCODE_Z)) camera.zoom *= 1.02f;
+    if (check_key(SDL_SCANCODE_C)) camera.zoom /= 1.02f;
+    if (check_key(SDL_SCANCODE_R)) camera.rotation += 1;
+    if (check_key_pressed(SDL_SCANCODE_TAB)) show_minimap = !show_minimap;
+    if (check_key_pressed(SDL_SCANCODE_P)) pacer_settings().mode = (Pacing_mode)((pacer_settings().mode + 1) % 3);
+    minimap.position = camera.center() - minimap.size / 2;
+
+    // TEST Particle burst on mouse position
+    if (check_key(SDL_SCANCODE_F) && ls.spark_emitter != -1) {
+        particle_emitter_get(ls.spark_emitter).position = m_w;
+        particle_emit(ls.spark_emitter, 500);
+    }
+
+    // TEST Particle stress, keeps STRESS_PARTICLES alive around the camera
+    if (check_key_pressed(SDL_SCANCODE_B)) {
+        if (ls.stress_emitter == -1) {
+            Particle_emitter stress;
+            stress.sprite_id    = "enemy"_spr;
+            stress.depth        = 300;
+            stress.capacity     = STRESS_PARTICLES;
+            stress.rate         = STRESS_PARTICLES / 2.0f;     // Lives average 2 seconds
+            stress.position     = camera.center();
+            stress.spread       = camera.size / 2;
+            stress.velocity_min = {-40, -40};
+            stress.velocity_max = {40, 40};
+            stress.life_min     = 1.5f;
+            stress.life_max     = 2.5f;
+            stress.size_start   = 0.25f;
+            stress.size_end     = 0.25f;
+            stress.animate      = false;
+            ls.stress_emitter = particle_emitter_add(stress);
+        }
+        else {
+            particle_emitter_remove(ls.stress_emitter);
+            ls.stress_emitter = -1;
+        }
+    }
+
+    Uint64 particle_start = SDL_GetTicksNS();
+    particle_update(dt);
+    particle_update_ms = (SDL_GetTicksNS() - particle_start) / 1e6;
     
     // TEST Spawn on mouse position
-    if (spwn_time > 0) {
-        spwn_time -= delta_time;
+    if (ls.spawn_time > 0) {
+        ls.spawn_time -= dt * 1000;
         return;
     }
 
-    std::string id = (check_key(SDL_SCANCODE_E) ? "enemy" : "none");
+    const char* id = (check_key(SDL_SCANCODE_E) ? "enemy" : nullptr);
     id = (check_key(SDL_SCANCODE_Q) ? "cat" : id);
 
-    if (id != "none") {
+    if (id != nullptr) {
         entity_spawn(id, {m_w.x(), m_w.y()}, {1, 1}, 0, TOP_CENTER, 100);
-        spwn_time = 30;
+        ls.spawn_time = 30;
     }
 }
 
 // Renders Drawable Objects ===========================================================
-void render(const global_state gs, const local_state ls) {
+void render(Scene& /* scene */) {
     /* CODE (Always white on start) */
+    draw_backdrop();
     draw_sprite_raw(spr_player, 0, 45, {200, 200, 200, 200});
 }
 
+// Far backdrop of still cat tiles, only submitted until the static layer has baked it
+void draw_backdrop() {
+    if (render_layer_get("backdrop").baked) return;
+
+    const Sprite_sheet_data& cat = sprite_get("cat"_spr);
+    Vector2f size = cat.frame_size.cast<float>();
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 40; col++) {
+            Vector2f at = Vector2f(col - 20, row - 4).cwiseProduct(size * 1.5f);
+            std::array<Vector2f, 4> quad = {at, at + Vector2f(size.x(), 0), at + size, at + Vector2f(0, size.y())};
+            render_batch_sprite(cat.sprite_id, (row + col) % cat.frame_count, 0, {1, 1}, 50, quad);
+        }
+    }
+}
+
+// Scene unload, the arena takes the entities and local_state with it ==============
+void unload(Scene& scene) {
+    local_state& ls = *(local_state*)scene.state;
+    particle_emitter_remove(ls.spark_emitter);
+    particle_emitter_remove(ls.stress_emitter);
+    render_layer_remove("actors");
+    render_layer_remove("backdrop");
+    debug_entity(nullptr);
+}
+
 // Debug shit
 void debug_update() {
     if (!is_event_active(DEBUG_MODE)) return;
-    snprintf(dbg_stats[0], 64, "FPS: %.2f", current_fps);
+    const Pacing_stats& pacing = pacer_stats();
+    snprintf(dbg_stats[0], 64, "FPS: %.2f (%s)", pacing.fps, pacer_mode_name(pacer_settings().mode));
     snprintf(dbg_stats[1], 64, "Sprite Loaded: %d", sprite_count());
     snprintf(dbg_stats[2], 64, "Entity Count: %d", entity_count());
     snprintf(dbg_stats[3], 64, "Rendered: %d", rendered_count());
-    snprintf(dbg_stats[4], 64, "Spawn time: %d", spwn_time);
+    Scene* scene = scene_current();
+    snprintf(dbg_stats[4], 64, "Scene: %s%s, %.0f KB arena", scene ? scene->name.c_str() : "none",
+        scene_loading() ? " (loading)" : "", scene ? arena_used(*scene->arena) / 1024.0 : 0.0);
 
     const char* dm = is_event_active(DEBUG_MODE) ? "true" : "false";
     snprintf(dbg_stats[5], 64, "Debug Mode: %s", dm);
     snprintf(dbg_stats[6], 64, "Camera Pos: %.2f, %.2f", camera.x(), camera.y());
+    snprintf(dbg_stats[7], 64, "Particles: %d, update %.2f ms, submit %.2f ms", particle_count(), particle_update_ms, particle_submit_ms);
+    const Atlas_stats& atlas = sprite_atlas_stats();
+    snprintf(dbg_stats[8], 64, "Atlas: %d pages, %.1f%% used, %.0f KB dedup", atlas.page_count, atlas.occupancy, atlas.dedup_bytes / 1024.0);
+    snprintf(dbg_stats[9], 64, "Textures: %.1f MB, %d/%d pages, %u evicted", atlas.resident_bytes / 1048576.0, atlas.resident_pages, sprite_atlas_page_count(), atlas.evictions);
+    snprintf(dbg_stats[10], 64, "Frame: %.2f ms, jitter %.2f, error %.3f / %.3f, %d missed",
+        pacing.frame_ms, pacing.jitter_ms, pacing.error_ms, pacing.error_max_ms, pacing.missed);
+    snprintf(dbg_stats[11], 64, "Frame arena: %.1f KB", frame_arena_used() / 1024.0);
+    snprintf(dbg_stats[12], 64, "Jobs: %d threads", jobs_thread_count());
 }
 
 
@@ -233,49 +368,75 @@ int main(int argc, char* argv[]) {
     SDL_Log("Application starting...");
     init();
 
-    global_state gs = {};
-    local_state ls = {};
-
-    Uint64 previous = SDL_GetTicks();
-    Uint64 lag = 0.0;
+    // Entities are spawned on a loading thread, the scene starts once they are ready
+    Scene demo;
+    demo.name    = "demo";
+    demo.preload = preload;
+    demo.start   = start;
+    demo.update  = update;
+    demo.render  = render;
+    demo.unload  = unload;
+    scene_push(demo);
 
-    Uint64 before = SDL_GetTicks();
-    load_entities();
-    SDL_Log("Time to load: %d ms.", SDL_GetTicks() - before);
+    timestep_settings().tick_rate = TICK_RATE;
+    timestep_settings().max_updates = MAX_CATCH_UP;
 
     // Game Loop
     while (game_running)
     {
-        Uint64 frame_start = SDL_GetTicks();
-
-        // Start event
-        if (invokeStart) {
-            start();
-            invokeStart = false;
-        }
-
-        Uint64 current = SDL_GetTicks();
-        delta_time = current - previous;
-        previous = current;
-        lag += delta_time;
-
-        // Lag Compensation
+        // Fixed timestep, as many ticks as the elapsed time covers
+        int updates = timestep_advance();
         game_running = input_handle_event(&event);
-        while (lag >= MS_PER_FRAME)
+        for (int i = 0; i < updates; i++)
         {
-            update(gs, ls);
+            entity_snapshot_all();
+            camera_prev = camera;
+            minimap_prev = minimap;
+            scene_update(timestep_dt());
             debug_update();
-            lag -= MS_PER_FRAME; 
         }
+
+        // Rendering sits between the last two ticks
+        float alpha = timestep_alpha();
+        Camera cam_view = camera_lerp(camera_prev, camera, alpha);
+        Camera minimap_view = camera_lerp(minimap_prev, minimap, alpha);
  
-        // Entities rendering
+        // Sprites decoded in the background since last frame
+        sprite_stream_update();
+
+        // Entities rendering, the ones no camera can see aren't animated nor submitted
+        Vector4f view_box = cam_view.bbox();
+        if (show_minimap) {
+            Vector4f mini_box = minimap_view.bbox();
+            view_box.head<2>() = view_box.head<2>().cwiseMin(mini_box.head<2>());
+            view_box.tail<2>() = view_box.tail<2>().cwiseMax(mini_box.tail<2>());
+        }
+        view_box += Vector4f(-1, -1, 1, 1) * cam_culling_margin();
+
+        // Culling and transforms are per entity so they run on the workers, batching stays on this thread
+        entity_anim_clock() = SDL_GetTicks();
+        Entity_range entities = entity_all();
+        int entity_total = (int)(entities.last - entities.first);
+        bool* drawn = (bool*)frame_alloc(SDL_max(entity_total, 1));
+        job_parallel_for(entity_total, ENTITY_JOB_GRAIN, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                Entity& value = *entities.first[i];
+                drawn[i] = value.may_overlap(view_box) || !render_depth_cullable(value.depth);
+                if (!drawn[i]) continue;
+                value.update_frame(entity_anim_clock());
+                value.update_vertices();
+                value.apply_transform(alpha);
+            }
+        });
+
         render_batch_clear_all();
-        for (auto& [key, value] : entity_get_map()) {
-            value.update_frame(current);
-            value.update_vertices();
-            value.apply_transform();
-            value.submit_vertices(camera);
+        for (int i = 0; i < entity_total; i++) {
+            if (drawn[i]) entities.first[i]->submit_vertices();
         }
+        Uint64 particle_start = SDL_GetTicksNS();
+        particle_submit(view_box);
+        particle_submit_ms = (SDL_GetTicksNS() - particle_start) / 1e6;
+        text_cache_trim();
 
         // Rendering
         gui_draw_ready(ui_manager);
@@ -289,25 +450,24 @@ int main(int argc, char* argv[]) {
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         SDL_RenderClear(renderer);
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // Always reset back to white
-        render(gs, ls);
+        scene_render();
         
         // Renders all vertex buffers with texture i.e, An Entity lol
-        render_batch_all(true);
+        render_batch_all(cam_view, true);
+        if (show_minimap) {
+            SDL_FRect frame = {minimap_view.viewport_pos.x(), minimap_view.viewport_pos.y(), minimap_view.size.x(), minimap_view.size.y()};
+            SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+            SDL_RenderFillRect(renderer, &frame);
+            render_batch_all(minimap_view, false);
+        }
         ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
         SDL_RenderPresent(renderer); 
 
-        // Frame time
-        Uint64 frame_end = SDL_GetTicks();
-        Uint64 frame_time = frame_end - frame_start;
-
-        frame_count++;
-        frame_timer += frame_time;
-        if (frame_timer >= 1000) {
-            current_fps = (frame_count * 1000 / frame_timer);
-            frame_count = 0;
-            frame_timer = 0;
-        }
+        // Transient allocations of this frame are dropped at once
+        frame_arena_reset();
 
+        // Frame pacing
+        pacer_frame_end();
     }
 
     app_quit();
@@ -317,6 +477,10 @@ int main(int argc, char* argv[]) {
 
 // System CLean-up
 void app_quit() {
+    scene_cleanup();
+    jobs_shutdown();
+    particle_cleanup();
+    text_cleanup();
     sprite_cleanup();
     if (win != nullptr) SDL_DestroyWindow(win);
     if (renderer != nullptr) SDL_DestroyRenderer(renderer);
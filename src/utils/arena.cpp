@@ -0,0 +1,133 @@
+#include "arena.hpp"
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <cstdint>
+
+// Block bytes start right after the header, aligned like malloc's result
+static const size_t BLOCK_HEADER = (sizeof(Arena_block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+static unsigned char* block_data(Arena_block* block) {
+    return (unsigned char*)block + BLOCK_HEADER;
+}
+
+
+// Offset of the next 'align'-ed address inside the block, past its used bytes
+static size_t aligned_offset(Arena_block* block, size_t align) {
+    uintptr_t at = (uintptr_t)(block_data(block) + block->used);
+    return block->used + ((align - (at & (align - 1))) & (align - 1));
+}
+
+
+void* arena_alloc(Arena& arena, size_t size, size_t align) {
+    // Blocks after 'current' are left over from before the last reset, reuse them first
+    for (Arena_block* block = arena.current; block != nullptr; block = block->next) {
+        if (block != arena.current) block->used = 0;
+        size_t offset = aligned_offset(block, align);
+        if (offset + size <= block->size) {
+            arena.current = block;
+            block->used = offset + size;
+            return block_data(block) + offset;
+        }
+    }
+
+    size_t bytes = SDL_max(arena.block_size, size + align);
+    Arena_block* block = (Arena_block*)SDL_malloc(BLOCK_HEADER + bytes);
+    if (block == nullptr) {
+        SDL_Log("Arena out of memory. {%zu bytes}", bytes);
+        return nullptr;
+    }
+    block->next = nullptr;
+    block->size = bytes;
+    block->used = 0;
+
+    // Chained at the end, after any block too small for this allocation
+    Arena_block** tail = &arena.head;
+    while (*tail != nullptr) tail = &(*tail)->next;
+    *tail = block;
+
+    size_t offset = aligned_offset(block, align);
+    arena.current = block;
+    block->used = offset + size;
+    return block_data(block) + offset;
+}
+
+
+void arena_reset(Arena& arena) {
+    for (Arena_dtor* dtor = arena.dtors; dtor != nullptr; dtor = dtor->next) {
+        dtor->destroy(dtor->object);
+    }
+    arena.dtors = nullptr;
+    arena.current = arena.head;
+    if (arena.head != nullptr) arena.head->used = 0;
+}
+
+
+void arena_release(Arena& arena) {
+    arena_reset(arena);
+    for (Arena_block* block = arena.head; block != nullptr;) {
+        Arena_block* next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+    arena.head = nullptr;
+    arena.current = nullptr;
+}
+
+
+size_t arena_used(const Arena& arena) {
+    size_t used = 0;
+    for (Arena_block* block = arena.head; block != nullptr; block = block->next) {
+        used += block->used;
+        if (block == arena.current) break;
+    }
+    return used;
+}
+
+
+size_t arena_capacity(const Arena& arena) {
+    size_t capacity = 0;
+    for (Arena_block* block = arena.head; block != nullptr; block = block->next) {
+        capacity += block->size;
+    }
+    return capacity;
+}
+
+
+// ============= Frame arena ==================== //
+
+struct Frame_arena {
+    Arena arena;
+    Uint64 frame = 0;           // Frame the arena was last rewound for
+    size_t last_used = 0;       // Bytes used in that frame's predecessor
+    ~Frame_arena() { arena_release(arena); }
+};
+
+static std::atomic<Uint64> current_frame = 1;
+static thread_local Frame_arena frame_arena;
+
+
+// Threads rewind their own arena, so the main thread never touches another thread's blocks
+static Frame_arena& frame_arena_now() {
+    Uint64 frame = current_frame.load(std::memory_order_relaxed);
+    if (frame_arena.frame != frame) {
+        frame_arena.last_used = (frame_arena.frame + 1 == frame) ? arena_used(frame_arena.arena) : 0;
+        arena_reset(frame_arena.arena);
+        frame_arena.frame = frame;
+    }
+    return frame_arena;
+}
+
+
+void* frame_alloc(size_t size, size_t align) {
+    return arena_alloc(frame_arena_now().arena, size, align);
+}
+
+
+void frame_arena_reset() {
+    current_frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+size_t frame_arena_used() {
+    return frame_arena_now().last_used;
+}
@@ -0,0 +1,179 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <utility>
+
+#define ARENA_BLOCK_SIZE (256 * 1024)
+
+/**
+ * @brief One chunk of arena memory, its bytes follow the header.
+ */
+struct Arena_block {
+    Arena_block* next;      /**< Next block, kept across resets. */
+    size_t size;            /**< Usable bytes after the header. */
+    size_t used;            /**< Bytes handed out since the block was last reached. */
+};
+
+/**
+ * @brief Destructor to run when the arena is reset, stored inside the arena.
+ */
+struct Arena_dtor {
+    Arena_dtor* next;               /**< Previously registered destructor. */
+    void (*destroy)(void* object);  /**< Calls the object's destructor. */
+    void* object;                   /**< The object to destroy. */
+};
+
+/**
+ * @brief Bump allocator made of a chain of blocks.
+ *
+ * Allocating moves a pointer forward, nothing is freed on its own. arena_reset
+ * rewinds to the first block in O(1), keeping every block for the next user, so
+ * a scene reloading into the same arena doesn't touch the heap again.
+ * Not thread safe, an arena belongs to one thread at a time.
+ */
+struct Arena {
+    Arena_block* head = nullptr;            /**< First block. */
+    Arena_block* current = nullptr;         /**< Block allocations come from, the ones after it are free. */
+    size_t block_size = ARENA_BLOCK_SIZE;   /**< Minimum size of new blocks. */
+    Arena_dtor* dtors = nullptr;            /**< Objects with a destructor, most recent first. */
+};
+
+
+/**
+ * @brief Allocates uninitialized memory from an arena, a new block is chained when the current one is full.
+ * @param arena The arena.
+ * @param size Bytes to allocate.
+ * @param align Alignment, a power of two.
+ * @return Pointer to the memory, valid until the arena is reset or released.
+ */
+void* arena_alloc(Arena& arena, size_t size, size_t align = alignof(std::max_align_t));
+
+
+/**
+ * @brief Runs the registered destructors and rewinds the arena, its blocks are kept.
+ * @param arena The arena.
+ */
+void arena_reset(Arena& arena);
+
+
+/**
+ * @brief Resets the arena and frees its blocks.
+ * @param arena The arena.
+ */
+void arena_release(Arena& arena);
+
+
+/**
+ * @brief Returns the bytes handed out since the last reset (padding included).
+ * @param arena The arena.
+ * @return The used bytes.
+ */
+size_t arena_used(const Arena& arena);
+
+
+/**
+ * @brief Returns the bytes of every block of the arena.
+ * @param arena The arena.
+ * @return The reserved bytes.
+ */
+size_t arena_capacity(const Arena& arena);
+
+
+/**
+ * @brief Constructs an object inside an arena.
+ *        Objects with a non-trivial destructor are destroyed by arena_reset, in reverse order.
+ * @param arena The arena.
+ * @param args Constructor arguments.
+ * @return Pointer to the object.
+ */
+template <typename T, typename... Args>
+T* arena_new(Arena& arena, Args&&... args) {
+    T* object = new (arena_alloc(arena, sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        Arena_dtor* dtor = (Arena_dtor*)arena_alloc(arena, sizeof(Arena_dtor), alignof(Arena_dtor));
+        dtor->destroy = [](void* p) { ((T*)p)->~T(); };
+        dtor->object = object;
+        dtor->next = arena.dtors;
+        arena.dtors = dtor;
+    }
+    return object;
+}
+
+
+/**
+ * @brief Allocates a value initialized array inside an arena.
+ * @param arena The arena.
+ * @param count Number of elements.
+ * @return Pointer to the first element.
+ */
+template <typename T>
+T* arena_new_array(Arena& arena, size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>, "Arena arrays are never destroyed");
+    T* items = (T*)arena_alloc(arena, sizeof(T) * count, alignof(T));
+    for (size_t i = 0; i < count; i++) new (items + i) T();
+    return items;
+}
+
+
+// ============= Frame arena ==================== //
+
+
+/**
+ * @brief Allocates transient memory that is valid until the end of the current frame.
+ *
+ * Every thread bumps its own arena, so there is no locking. A thread rewinds its
+ * arena the first time it allocates after frame_arena_reset, nothing is freed one
+ * by one. Memory must not be kept across frames.
+ *
+ * @param size Bytes to allocate.
+ * @param align Alignment, a power of two.
+ * @return Pointer to the memory.
+ */
+void* frame_alloc(size_t size, size_t align = alignof(std::max_align_t));
+
+
+/**
+ * @brief Ends the frame for every thread's frame arena. Call once at the end of each frame, on the main thread.
+ */
+void frame_arena_reset();
+
+
+/**
+ * @brief Bytes the calling thread took from its frame arena during its last finished frame.
+ * @return The used bytes.
+ */
+size_t frame_arena_used();
+
+
+/**
+ * @brief STL allocator over frame_alloc, deallocation does nothing.
+ *        Containers using it must not outlive the frame, reserve them to avoid leaving grown-out copies behind.
+ */
+template <typename T>
+struct Frame_allocator {
+    using value_type = T;
+
+    Frame_allocator() = default;
+    template <typename U> Frame_allocator(const Frame_allocator<U>&) {}
+
+    T* allocate(size_t count) {
+        void* memory = frame_alloc(count * sizeof(T), alignof(T));
+        if (memory == nullptr) throw std::bad_alloc();
+        return (T*)memory;
+    }
+    void deallocate(T*, size_t) {}
+
+    template <typename U> bool operator==(const Frame_allocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const Frame_allocator<U>&) const { return false; }
+};
+
+template <typename T>
+using Frame_vector = std::vector<T, Frame_allocator<T>>;
+using Frame_string = std::basic_string<char, std::char_traits<char>, Frame_allocator<char>>;
+
+#endif
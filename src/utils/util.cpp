@@ -1,14 +1,24 @@
-#include <SDL3_image/SDL_image.h>
 #include <SDL3/SDL.h>
-#include <dirent.h>
 #include <string>
 #include <vector>
 #include <regex>
 #include <cmath>
 #include "util.hpp"
+#include "../core/jobs.hpp"
 #include <Eigen/Dense>
 using namespace Eigen;
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define PI SDL_PI_F
 
 float deg_to_rad(float deg) {
@@ -25,6 +35,12 @@ float distance(const Vector2f& a, const Vector2f& b) {
     );
 }
 
+void parallel_for(int count, const std::function<void(int)>& fn) {
+    job_parallel_for(count, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) fn(i);
+    });
+}
+
 Vector2f get_pivot_offset(Pivot_Type pivot_type, const Vector2f& size) {
     float x = 0.0f;
     float y = 0.0f;
@@ -39,6 +55,7 @@ Vector2f get_pivot_offset(Pivot_Type pivot_type, const Vector2f& size) {
         case BOTTOM_LEFT:     x = 0.0f;     y = 1.0f; break;
         case BOTTOM_CENTER:   x = 0.5f;     y = 1.0f; break;
         case BOTTOM_RIGHT:    x = 1.0f;     y = 1.0f; break;
+        case SPRITE_PIVOT:    break;
     }
 
     return Vector2f(x * size.x(), y * size.y());
@@ -56,88 +73,81 @@ const char* get_pivot_name(Pivot_Type pivot) {
         case BOTTOM_LEFT:     return "Bottom Left";
         case BOTTOM_CENTER:   return "Bottom Center";
         case BOTTOM_RIGHT:    return "Bottom Right";
+        case SPRITE_PIVOT:    return "Sprite";
     }
     return "Custom";
 }
 
 
-void generate_sprite_sheet(const std::string dir_p, const std::string output) {
-    // check for folder existance
-    DIR* dir = opendir(dir_p.c_str());
-    if (dir == nullptr) {
-        SDL_Log("Directory not Found. {%s}", dir_p.c_str());
-        return;
-    }
+void str_toLower(std::string& str) {
+    for (auto& x : str) {x = tolower(x);}
+}
 
-    // Folder walkthrough
-    int i = 0;
-    dirent* entity = readdir(dir);
-    std::vector<SDL_Surface*> frames;
-
-    // Get every frame as a surface
-    while(entity != nullptr) {
-
-        std::string img_path = (std::string(dir_p) + "/" + entity->d_name);
-        SDL_Surface* frame = IMG_Load(img_path.c_str());
-        if (frame == nullptr) {
-            i++;
-            entity = readdir(dir);
-            continue;
-        }
-
-        frames.push_back(frame);
-        entity = readdir(dir);
-        i++;
-    }
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hval = seed;
 
-    // Validation
-    if (frames.empty()) {
-        SDL_Log("No Frames found. {%s}", dir_p.c_str());
-        closedir(dir);
+    for (size_t i = 0; i < size; i++) {
+        hval ^= bytes[i];
+        hval *= FNV_PRIME;
     }
+    return hval;
+}
 
-    // Create a surface with the appropriate dimensions
-    int frame_w = frames[0]->w;
-    int frame_h = frames[0]->h;
-    int total_w = frame_w * frames.size();
+bool map_file(const std::string& path, Mapped_file& out) {
+    out = Mapped_file{};
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
 
-    SDL_Surface* sprite_sheet_surf = SDL_CreateSurface(
-        total_w, frame_h, SDL_PIXELFORMAT_RGBA32
-    );
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);      // The mapping keeps the file open
+    if (mapping == nullptr) return false;
 
-    // Copy each frame to the sprite sheet surface
-    for (int i = 0; i < frames.size(); i++) {
-        SDL_Rect dest = {i * frame_w, 0, frame_w, frame_h};
-        SDL_BlitSurface(frames[i], nullptr, sprite_sheet_surf, &dest);
-        SDL_DestroySurface(frames[i]);
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return false;
     }
-    frames.clear();
-    
-    // Save as a Spritesheet file.
-    IMG_SavePNG(sprite_sheet_surf, output.c_str());
-    SDL_DestroySurface(sprite_sheet_surf);
-    SDL_Log("> UTIL s> Sprite sheet generated. {%s}", output.c_str());
-}
 
-void str_toLower(std::string& str) {
-    for (auto& x : str) {x = tolower(x);}
-}
+    out.data = (const uint8_t*)view;
+    out.size = (size_t)size.QuadPart;
+    out.handle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);              // The mapping keeps the file open
+    if (view == MAP_FAILED) return false;
 
-uint64_t hash_string(const std::string& str) {
-    // p is a prime number
-    // m is a large prime number
-    long p = 31, m = (long) 1e9 + 9;
+    out.data = (const uint8_t*)view;
+    out.size = (size_t)st.st_size;
+#endif
+    return true;
+}
 
-    long hval = 0;
-    long pPow = 1;
 
-    for (int i = 0; i < str.length(); i++) {
-        hval = (hval + (str[i] - 'a' + 1)) * pPow % m;
-        pPow = (pPow * p) % m;
-    }
-    return hval;
+void unmap_file(Mapped_file& file) {
+    if (file.data == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+    CloseHandle((HANDLE)file.handle);
+#else
+    munmap((void*)file.data, file.size);
+#endif
+    file = Mapped_file{};
 }
 
+
 uint32_t extract_frame_count(const std::string& filename) {
     std::regex frame_regex("spr_.*_(\\d+)\\.png$");
     std::smatch match;
@@ -2,6 +2,8 @@
 #define UTIL_HPP
 
 #include <string>
+#include <string_view>
+#include <functional>
 #include <Eigen/Dense>
 using namespace Eigen;
 
@@ -11,7 +13,8 @@ using namespace Eigen;
 enum Pivot_Type {
     TOP_LEFT, TOP_CENTER, TOP_RIGHT,
     MIDDLE_LEFT, MIDDLE_CENTER, MIDDLE_RIGHT,
-    BOTTOM_LEFT, BOTTOM_CENTER, BOTTOM_RIGHT
+    BOTTOM_LEFT, BOTTOM_CENTER, BOTTOM_RIGHT,
+    SPRITE_PIVOT    // Per frame pivot from the sprite's manifest, offset (0, 0) here
 };
 
 /**
@@ -26,26 +29,6 @@ Vector2f get_pivot_offset(Pivot_Type pivot_type, const Vector2f& size);
 const char* get_pivot_name(Pivot_Type pivot);
 
 
-/**
- * @brief Generates a sprite sheet from individual frames.
- *
- * @param dir_p Absolute path to the directory containing all sprite frame images.
- *            Each frame should be named based on its index in the animation timeline,
- *            e.g., "0.png", "1.png", ..., "5.png" for a 6-frame animation.
- *
- * @param output Absolute path to the output sprite sheet file.
- *            The output filename should follow the format:
- *              spr_<name>_<frame_count>.png
- *            For example: "spr_player_6.png" represents a sprite sheet with 6 frames.
- *
- * @note
- *   - Frames are arranged left to right in the final sheet.
- * 
- *   - All frames must have the same dimensions.
- */
-void generate_sprite_sheet(const std::string dir_p, const std::string output);
-
-
 /**
  * @brief Converts all characters in the input string to lowercase (in-place).
  * 
@@ -57,10 +40,38 @@ void generate_sprite_sheet(const std::string dir_p, const std::string output);
 void str_toLower(const std::string& str);
 
 
-// Use Polynomial rolling hash function, for this case
-// Generally used for Sprite_ID Generation
-// But can still be applied to anywhere
-uint64_t hash_string(const std::string& str);
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+
+/**
+ * @brief Hashes a string with 64-bit FNV-1a, same result as hash_bytes over its characters.
+ * 
+ * Generally used for Sprite_ID Generation (see the "name"_spr literal), but can
+ * still be applied to anywhere. constexpr, so constant names hash at compile time.
+ * 
+ * @param str The string to hash.
+ * @return The 64-bit hash.
+ */
+constexpr uint64_t hash_string(std::string_view str) {
+    uint64_t hval = FNV_OFFSET_BASIS;
+    for (char c : str) {
+        hval ^= (unsigned char)c;
+        hval *= FNV_PRIME;
+    }
+    return hval;
+}
+
+
+/**
+ * @brief Hashes a block of bytes with 64-bit FNV-1a.
+ * 
+ * @param data The bytes to hash.
+ * @param size Number of bytes.
+ * @param seed Previous hash to chain several blocks, defaults to the FNV offset basis.
+ * @return The 64-bit hash.
+ */
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
 
 
 /**
@@ -79,6 +90,47 @@ uint32_t extract_frame_count(const std::string& filename);
 std::string extract_sprite_name(const std::string& filename);
 
 
+/**
+ * @brief Calls fn(i) for every i in [0, count) spread over the job workers (see job_parallel_for).
+ * 
+ * Blocks until every call returned. Calls run in no particular order, so fn
+ * must only touch data owned by index i.
+ * 
+ * @param count Number of indices.
+ * @param fn The work for a single index.
+ */
+void parallel_for(int count, const std::function<void(int)>& fn);
+
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+struct Mapped_file {
+    const uint8_t* data = nullptr;  /**< First byte of the file, nullptr when not mapped. */
+    size_t size = 0;                /**< File size in bytes. */
+    void* handle = nullptr;         /**< Platform mapping handle (Windows only). */
+};
+
+
+/**
+ * @brief Maps a file read-only into memory (MapViewOfFile on Windows, mmap elsewhere).
+ * 
+ * Pages are loaded from the OS page cache on first touch, nothing is copied up front.
+ * 
+ * @param path The file path.
+ * @param out The mapping, left empty on failure.
+ * @return False when the file can't be opened or mapped.
+ */
+bool map_file(const std::string& path, Mapped_file& out);
+
+
+/**
+ * @brief Releases a mapping made by map_file.
+ * @param file The mapping, reset to empty.
+ */
+void unmap_file(Mapped_file& file);
+
+
 /**
  * @brief Converts degrees to radians.
  * @param deg Angle in degrees.
@@ -0,0 +1,29 @@
+#include "../src/core/jobs.hpp"
+#include <SDL3/SDL.h>
+#include <cstdlib>
+
+// Job system overhead benchmark, kept out of the game's startup:
+//   jobbench [job_count] [workers]     (defaults to 200000 jobs, one worker per core minus one)
+// Times empty jobs from submit to the end of the wait, then job_parallel_for over
+// empty items at a few grain sizes.
+int main(int argc, char* argv[]) {
+    int job_count = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    int workers = (argc > 2) ? std::atoi(argv[2]) : 0;
+    if (job_count <= 0 || workers < 0) {
+        SDL_Log("Usage: jobbench [job_count] [workers]");
+        return 1;
+    }
+
+    jobs_init(workers);
+    job_benchmark(JOB_QUEUE_SIZE);      // Warm up, wakes every worker once
+    SDL_Log("Empty jobs: %.0f ns per job. {%d jobs, %d threads}", job_benchmark(job_count), job_count, jobs_thread_count());
+
+    for (int grain : {1, 16, 256}) {
+        Uint64 start = SDL_GetTicksNS();
+        job_parallel_for(job_count, grain, [](int, int) {});
+        SDL_Log("Parallel for, grain %d: %.1f ns per item", grain, (SDL_GetTicksNS() - start) / (double)job_count);
+    }
+
+    jobs_shutdown();
+    return 0;
+}
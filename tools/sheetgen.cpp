@@ -0,0 +1,228 @@
+#include "../src/engine/atlas.hpp"
+#include "../src/engine/sheet_meta.hpp"
+#include "../src/utils/util.hpp"
+#include "../src/core/jobs.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Sprite sheet generator, turns a folder of numbered frames into one sheet:
+//   sheetgen <frames_dir> <output> [max_width]
+//
+// Frames are named by their index in the animation ("0.png", "1.png", "10.png", ...)
+// and ordered numerically. They are laid out row-major in a grid no wider than
+// max_width (defaults to MAX_ATLAS_SIZE), the layout goes into the .sheet manifest
+// next to the sheet so the sprite loader can slice it (see sheet_meta.hpp).
+//
+// <output> is either the full spr_<name>_<frame_count>.png path, or just the
+// spr_<name> prefix, in which case the frame count gets appended.
+//
+// Frames are decoded on every core, each worker blits its frame straight into
+// the sheet and frees it, so at most one decoded frame per core is alive at once.
+// The result only depends on the frame pixels, the same folder always gives the
+// same bytes.
+
+struct Frame_file {
+    long index;
+    std::string name;
+};
+
+
+// Numeric stem ("12.png" -> 12), -1 when the name isn't a frame index
+static long frame_index(const std::string& name) {
+    size_t dot = name.find_last_of('.');
+    if (dot == 0 || dot == std::string::npos) return -1;
+    for (size_t i = 0; i < dot; i++) {
+        if (name[i] < '0' || name[i] > '9') return -1;
+    }
+    return std::strtol(name.substr(0, dot).c_str(), nullptr, 10);
+}
+
+
+static bool list_frames(const std::string& dir_p, std::vector<Frame_file>& out) {
+    DIR* dir = opendir(dir_p.c_str());
+    if (dir == nullptr) {
+        SDL_Log("Directory not Found. {%s}", dir_p.c_str());
+        return false;
+    }
+
+    for (dirent* entity = readdir(dir); entity != nullptr; entity = readdir(dir)) {
+        std::string name = entity->d_name;
+        long index = frame_index(name);
+        if (index < 0) continue;
+        out.push_back({index, name});
+    }
+    closedir(dir);
+
+    // readdir order is filesystem dependent, the timeline order is the numeric one
+    std::sort(out.begin(), out.end(), [](const Frame_file& a, const Frame_file& b) {
+        return a.index != b.index ? a.index < b.index : a.name < b.name;
+    });
+    for (size_t i = 1; i < out.size(); i++) {
+        if (out[i].index == out[i - 1].index) {
+            SDL_Log("Two frames with index %ld. {%s, %s}", out[i].index, out[i - 1].name.c_str(), out[i].name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static SDL_Surface* load_frame(const std::string& path) {
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (loaded == nullptr || loaded->format == SDL_PIXELFORMAT_RGBA32) return loaded;
+    SDL_Surface* converted = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    return converted;
+}
+
+
+// Resolves <output> to spr_<name>_<frame_count>.png, empty when it names another frame count
+static std::string sheet_path(const std::string& output, int frame_count) {
+    size_t slash = output.find_last_of("/\\");
+    std::string base = (slash == std::string::npos) ? output : output.substr(slash + 1);
+    if (base.size() < 4 || base.compare(base.size() - 4, 4, ".png") != 0) {
+        return output + "_" + std::to_string(frame_count) + ".png";
+    }
+
+    if ((int)extract_frame_count(base) != frame_count) {
+        SDL_Log("Output name doesn't match the %d frames found, expected spr_<name>_%d.png. {%s}",
+            frame_count, frame_count, base.c_str());
+        return "";
+    }
+    return output;
+}
+
+
+// Writes the layout part of the manifest, hand written directives (fps, loop, pivots...) of an existing one are kept
+static bool write_sheet_meta(const std::string& sheet_file, int frame_count, int frame_w, int frame_h, int columns, int rows) {
+    std::string meta_file = sheet_file.substr(0, sheet_file.size() - 4) + SHEET_META_EXT;
+
+    std::string kept;
+    size_t size = 0;
+    char* old = (char*)SDL_LoadFile(meta_file.c_str(), &size);
+    if (old != nullptr) {
+        std::istringstream lines(std::string(old, size));
+        SDL_free(old);
+        for (std::string line; std::getline(lines, line);) {
+            std::string directive;
+            std::istringstream(line) >> directive;
+            if (directive == "frames" || directive == "frame_size" || directive == "grid") continue;
+            kept += line + "\n";
+        }
+    }
+
+    SDL_IOStream* io = SDL_IOFromFile(meta_file.c_str(), "wb");
+    if (io == nullptr) {
+        SDL_Log("Failed to open sheet meta. {%s}", meta_file.c_str());
+        return false;
+    }
+
+    bool ok = SDL_IOprintf(io, "frames %d\nframe_size %d %d\ngrid %d %d\n", frame_count, frame_w, frame_h, columns, rows) > 0;
+    ok = (kept.empty() || SDL_WriteIO(io, kept.data(), kept.size()) == kept.size()) && ok;
+    ok = SDL_CloseIO(io) && ok;
+    if (!ok) SDL_Log("Failed to write sheet meta. {%s}", meta_file.c_str());
+    return ok;
+}
+
+
+static bool generate_sheet(const std::string& dir_p, const std::string& output, int max_width) {
+    std::vector<Frame_file> files;
+    if (!list_frames(dir_p, files)) return false;
+    if (files.empty()) {
+        SDL_Log("No Frames found. {%s}", dir_p.c_str());
+        return false;
+    }
+
+    int frame_count = (int)files.size();
+    std::string sheet_file = sheet_path(output, frame_count);
+    if (sheet_file.empty()) return false;
+
+    // The first frame decides the frame size, every other one must match it
+    SDL_Surface* first = load_frame(dir_p + "/" + files[0].name);
+    if (first == nullptr) {
+        SDL_Log("Failed to load frame. {%s}", files[0].name.c_str());
+        return false;
+    }
+    int frame_w = first->w;
+    int frame_h = first->h;
+    SDL_DestroySurface(first);
+
+    int columns = SDL_clamp(max_width / frame_w, 1, frame_count);
+    int rows = (frame_count + columns - 1) / columns;
+    if (columns * frame_w > MAX_ATLAS_SIZE || rows * frame_h > MAX_ATLAS_SIZE) {
+        SDL_Log("Sheet is %dx%d, larger than the %d atlas page it has to fit. {%s}",
+            columns * frame_w, rows * frame_h, MAX_ATLAS_SIZE, sheet_file.c_str());
+        return false;
+    }
+
+    // Zero filled, so unused grid cells are always transparent
+    SDL_Surface* sheet = SDL_CreateSurface(columns * frame_w, rows * frame_h, SDL_PIXELFORMAT_RGBA32);
+    if (sheet == nullptr) {
+        SDL_Log("Failed to create sheet surface. {%s}", SDL_GetError());
+        return false;
+    }
+
+    // Every frame owns its own cell, so workers can copy rows without locking
+    std::atomic<bool> failed = false;
+    parallel_for(frame_count, [&](int f) {
+        if (failed) return;
+        SDL_Surface* frame = load_frame(dir_p + "/" + files[f].name);
+        if (frame == nullptr || frame->w != frame_w || frame->h != frame_h) {
+            SDL_Log("Frame missing or not %dx%d. {%s}", frame_w, frame_h, files[f].name.c_str());
+            failed = true;
+            SDL_DestroySurface(frame);
+            return;
+        }
+
+        int x = (f % columns) * frame_w;
+        int y = (f / columns) * frame_h;
+        for (int row = 0; row < frame_h; row++) {
+            const Uint8* src = (const Uint8*)frame->pixels + row * frame->pitch;
+            Uint8* dst = (Uint8*)sheet->pixels + (y + row) * sheet->pitch + x * 4;
+            std::memcpy(dst, src, frame_w * 4);
+        }
+        SDL_DestroySurface(frame);
+    });
+
+    bool ok = !failed;
+    if (ok && !IMG_SavePNG(sheet, sheet_file.c_str())) {
+        SDL_Log("Failed to save sprite sheet. {%s, %s}", sheet_file.c_str(), SDL_GetError());
+        ok = false;
+    }
+    SDL_DestroySurface(sheet);
+    if (!ok) return false;
+
+    if (!write_sheet_meta(sheet_file, frame_count, frame_w, frame_h, columns, rows)) return false;
+
+    SDL_Log("> Sprite sheet generated. {%s, %d frames, %dx%d grid}", sheet_file.c_str(), frame_count, columns, rows);
+    return true;
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        SDL_Log("Usage: sheetgen <frames_dir> <output> [max_width]");
+        return 1;
+    }
+
+    int max_width = (argc > 3) ? std::atoi(argv[3]) : MAX_ATLAS_SIZE;
+    if (max_width <= 0) {
+        SDL_Log("Invalid max width. {%s}", argv[3]);
+        return 1;
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    bool generated = generate_sheet(argv[1], argv[2], max_width);
+    jobs_shutdown();                // parallel_for started the job workers, they must be joined before exit
+    if (!generated) return 1;
+    SDL_Log("Done in %.2f ms", (SDL_GetTicksNS() - start) / 1e6);
+    return 0;
+}
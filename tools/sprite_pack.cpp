@@ -0,0 +1,23 @@
+#include "../src/engine/sprite.hpp"
+#include "../src/core/jobs.hpp"
+#include <SDL3/SDL.h>
+#include <string>
+
+// Offline sprite packer, run from bin/ like the game itself:
+//   sprite_pack [output]     (defaults to assets/sprites.pack)
+// Decodes assets/sprites/*.png, packs them with the default atlas settings and
+// writes the pack the game maps at startup instead of decoding the PNGs.
+int main(int argc, char* argv[]) {
+    std::string output = (argc > 1) ? argv[1] : "assets/sprites.pack";
+
+    Uint64 start = SDL_GetTicksNS();
+    bool built = sprite_pack_build(output);
+    jobs_shutdown();                // Decoding started the job workers, they must be joined before exit
+    if (!built) {
+        SDL_Log("Sprite pack failed. {%s}", output.c_str());
+        return 1;
+    }
+
+    SDL_Log("Sprite pack written. {%s, %.2f ms}", output.c_str(), (SDL_GetTicksNS() - start) / 1e6);
+    return 0;
+}